@@ -0,0 +1,77 @@
+#ifndef COLOR_TABLE_H
+#define COLOR_TABLE_H
+
+#include <QString>
+#include <QFile>
+#include <QVector>
+#include <QRgb>
+
+#include <algorithm>
+#include <cmath>
+
+#include "array.h"
+
+using ColorTableVector = QVector<QVector<QRgb>>;
+
+class ColorTable
+{
+public:
+	explicit ColorTable(const QString& path = "ColorTable/")
+	{
+		// Color table list
+		m_cNameVector.push_back("gray");
+		m_cNameVector.push_back("invgray");
+		m_cNameVector.push_back("sepia");
+		m_cNameVector.push_back("jet");
+		m_cNameVector.push_back("parula");
+		m_cNameVector.push_back("hot");
+		m_cNameVector.push_back("fire");
+		// Add the file names of new color tables here
+
+		for (int i = 0; i < m_cNameVector.size(); i++)
+		{
+			QFile file(path + m_cNameVector.at(i) + ".colortable");
+			file.open(QIODevice::ReadOnly);
+			np::Uint8Array2 rgb(256, 3);
+			file.read(reinterpret_cast<char*>(rgb.raw_ptr()), sizeof(uint8_t) * rgb.length());
+			file.close();
+
+			QVector<QRgb> temp_vector;
+			for (int j = 0; j < 256; j++)
+			{
+				QRgb color = qRgb(rgb(j, 0), rgb(j, 1), rgb(j, 2));
+				temp_vector.push_back(color);
+			}
+			m_colorTableVector.push_back(temp_vector);
+		}
+	}
+
+	// Color tables loaded once for the process
+	static const ColorTable& instance()
+	{
+		static ColorTable colorTable;
+		return colorTable;
+	}
+
+	// Color table of the values quantized in [quantMin, quantMax] to be displayed in [min, max]
+	// (contrast is adjusted by the palette without touching the quantized images)
+	static QVector<QRgb> contrastTable(const QVector<QRgb>& ctable, int quantMin, int quantMax, int min, int max)
+	{
+		QVector<QRgb> palette(256);
+		float range = (max != min) ? (float)(max - min) : 1.0f; // max < min: inverted
+		float scale = (float)(quantMax - quantMin) / 255.0f / range;
+		for (int i = 0; i < 256; i++)
+		{
+			int j = (int)floor(255.0f * ((float)(quantMin - min) / range + scale * i) + 0.5f);
+			palette[i] = ctable.at(std::min(std::max(j, 0), 255));
+		}
+		return palette;
+	}
+
+public:
+	enum colortable { gray = 0, inv_gray, sepia, jet, parula, hot, fire }; // Add the names of new color tables here
+	QVector<QString> m_cNameVector;
+	ColorTableVector m_colorTableVector;
+};
+
+#endif // COLOR_TABLE_H
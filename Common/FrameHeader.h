@@ -0,0 +1,63 @@
+#ifndef FRAMEHEADER_H
+#define FRAMEHEADER_H
+
+#include <cstdint>
+#include <chrono>
+#include <type_traits>
+
+#define FRAME_FLAG_DISCONTINUITY	0x1 // Frames were dropped just before this frame
+
+// Metadata travelling alongside each frame buffer (stored in front of the buffers of SyncObject)
+struct FrameHeader
+{
+	uint32_t seq; // source frame number
+	uint32_t flags;
+	int64_t timestamp; // monotonic acquisition time [us]
+	int64_t reserved[2]; // keep 32-byte size (alignment of the following frame data)
+
+	static inline int64_t now()
+	{
+		return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+	}
+};
+
+// Latency & dropped frame statistics of a frame stream
+struct FrameMonitor
+{
+	FrameMonitor(uint32_t _step = 1) : step(_step), started(false), lastSeq(0) { clear(); }
+
+	void clear() { nFrames = 0; nDropped = 0; nSkipped = 0; latencySum = 0; latencyMax = 0; }
+
+	void update(const FrameHeader* header)
+	{
+		// Sequence gap (a restarted source is not counted)
+		if (started && (header->seq > lastSeq))
+			nDropped += (header->seq - lastSeq) / step - 1;
+		started = true;
+		lastSeq = header->seq;
+
+		// Latency from the acquisition
+		int64_t latency = FrameHeader::now() - header->timestamp;
+		latencySum += latency;
+		if (latency > latencyMax) latencyMax = latency;
+		nFrames++;
+	}
+
+	inline double meanLatency() const { return nFrames ? (double)latencySum / (double)nFrames / 1000.0 : 0.0; } // [ms]
+	inline double maxLatency() const { return (double)latencyMax / 1000.0; } // [ms]
+
+	uint32_t step;
+	bool started;
+	uint32_t lastSeq;
+
+	int nFrames;
+	int nDropped;
+	int nSkipped; // not displayed (newer frame available), counted by the consumer
+	int64_t latencySum, latencyMax;
+};
+
+// Header of a buffer allocated by SyncObject
+template <typename T>
+inline FrameHeader* frame_header(T* buffer) { return reinterpret_cast<FrameHeader*>(const_cast<typename std::remove_const<T>::type*>(buffer)) - 1; }
+
+#endif // FRAMEHEADER_H
@@ -0,0 +1,110 @@
+#ifndef FRAMESCHEDULER_H
+#define FRAMESCHEDULER_H
+
+#include <iostream>
+#include <vector>
+#include <mutex>
+#include <condition_variable>
+
+#include <Havana2/Configuration.h>
+
+// Order of the frames processed by multiple workers (a requested frame & its neighbors first)
+
+class FrameScheduler
+{
+public:
+	FrameScheduler() : m_nFrames(0), m_next(0), m_request(-1), m_bFinished(true) {}
+
+private:
+	enum state { pending = 0, processing, done };
+
+public:
+	void reset(int nFrames, bool processed = false)
+	{
+		std::unique_lock<std::mutex> lock(m_mtx);
+
+		m_state.assign(nFrames, processed ? done : pending);
+		m_nFrames = nFrames;
+		m_next = 0;
+		m_request = -1;
+		m_bFinished = processed;
+	}
+
+	int next() // -1 if no frame remains
+	{
+		std::unique_lock<std::mutex> lock(m_mtx);
+
+		int frame = -1;
+
+		// 1. Requested frame & its neighbors
+		if (m_request >= 0)
+		{
+			for (int d = 0; (d <= LAZY_PREFETCH_FRAMES) && (frame < 0); d++)
+			{
+				if (isPending(m_request + d)) frame = m_request + d;
+				else if (isPending(m_request - d)) frame = m_request - d;
+			}
+		}
+
+		// 2. The rest in order
+		for (; (frame < 0) && (m_next < m_nFrames); m_next++)
+			if (m_state[m_next] == pending) frame = m_next;
+
+		if (frame >= 0)
+			m_state[frame] = processing;
+
+		return frame;
+	}
+
+	void complete(int frame)
+	{
+		std::unique_lock<std::mutex> lock(m_mtx);
+		m_state[frame] = done;
+		m_cond.notify_all();
+	}
+
+	void finish() // no more frames will be completed
+	{
+		std::unique_lock<std::mutex> lock(m_mtx);
+		m_bFinished = true;
+		m_cond.notify_all();
+	}
+
+	void request(int frame)
+	{
+		std::unique_lock<std::mutex> lock(m_mtx);
+		if ((frame >= 0) && (frame < m_nFrames))
+			m_request = frame;
+	}
+
+	bool isDone(int frame)
+	{
+		std::unique_lock<std::mutex> lock(m_mtx);
+		return (frame >= 0) && (frame < m_nFrames) && (m_state[frame] == done);
+	}
+
+	bool wait(int frame) // false if the frame is not processed after all
+	{
+		std::unique_lock<std::mutex> lock(m_mtx);
+		if ((frame < 0) || (frame >= m_nFrames))
+			return false;
+
+		m_cond.wait(lock, [&]() { return (m_state[frame] == done) || m_bFinished; });
+		return m_state[frame] == done;
+	}
+
+private:
+	inline bool isPending(int frame) const { return (frame >= 0) && (frame < m_nFrames) && (m_state[frame] == pending); }
+
+private:
+	std::vector<state> m_state;
+	int m_nFrames;
+	int m_next; // next frame in order
+	int m_request; // most recently requested frame
+	bool m_bFinished;
+
+	std::mutex m_mtx;
+	std::condition_variable m_cond;
+};
+
+#endif // FRAMESCHEDULER_H
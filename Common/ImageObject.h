@@ -8,11 +8,15 @@
 #include <QVector>
 #include <QRgb>
 
+#include <ippi.h>
+
 #include <tbb/parallel_for.h>
 #include <tbb/blocked_range.h>
 
 #include "array.h"
 
+// RGB conversion by the palette functions of IPP (with the 4x horizontal upscaling)
+
 class ImageObject
 {
 public:
@@ -43,39 +47,44 @@ public:
 	int getHeight() const { return height; }
         const QVector<QRgb> getColorTable() const { return colortable; }
 
-	void convertRgb()
+	void setColorTable(const QVector<QRgb>& _colortable)
 	{
-		qrgbimg = QImage(width, height, QImage::Format_RGB888);
-		np::Uint8Array2 rgbarr(qrgbimg.bits(), 3 * width, height);
+		colortable = _colortable;
+		qindeximg.setColorTable(colortable);
+		arr = np::Uint8Array2(qindeximg.bits(), width, height); // in case of detaching
+	}
 
-		tbb::parallel_for(tbb::blocked_range<size_t>(0, (size_t)height),
-			[&](const tbb::blocked_range<size_t>& r) {
-			for (size_t i = r.begin(); i != r.end(); ++i)
-			{
-				for (int j = 0; j < width; j++)
-				{
-					QRgb val = colortable.at(arr(j, (int)i));
-					rgbarr(3 * j + 0, (int)i) = qRed(val);
-					rgbarr(3 * j + 1, (int)i) = qGreen(val);
-					rgbarr(3 * j + 2, (int)i) = qBlue(val);
-				}
-			}
-		});
+	void convertRgb(QImage::Format format = QImage::Format_RGB888)
+	{
+		qrgbimg = QImage(width, height, format);
+		applyPalette(1);
 	}
 
-	void convertScaledRgb()
+	void convertScaledRgb(QImage::Format format = QImage::Format_RGB888)
 	{
-		qrgbimg = std::move(qindeximg.scaled(4 * width, height).convertToFormat(QImage::Format_RGB888));
+		qrgbimg = QImage(4 * width, height, format);
+		applyPalette(4);
 	}
 
 	void convertNonScaledRgb()
 	{
-		qrgbimg = std::move(qindeximg.convertToFormat(QImage::Format_RGB888));
+		convertRgb();
 	}
 
 	void scaled4()
 	{
-		qindeximg = std::move(qindeximg.scaled(4 * width, height));
+		QImage scaled(4 * width, height, QImage::Format_Indexed8);
+		scaled.setColorTable(colortable);
+		uchar* pScaled = scaled.bits();
+		int step = scaled.bytesPerLine();
+
+		tbb::parallel_for(tbb::blocked_range<int>(0, height),
+			[&](const tbb::blocked_range<int>& r) {
+			for (int i = r.begin(); i != r.end(); ++i)
+				repeat4(arr.raw_ptr() + i * width, pScaled + i * step, width);
+		});
+
+		qindeximg = std::move(scaled);
 	}
 
 	void scaledRgb4()
@@ -85,14 +94,57 @@ public:
 
 	void setRgbChannelData(uchar* data, int ch)
 	{
-		for (int i = 0; i < height; i++)
+		IppiSize roi = { width, height };
+		ippiCopy_8u_C1C3R(data, width, qrgbimg.bits() + ch, qrgbimg.bytesPerLine(), roi);
+	}
+
+private:
+	void applyPalette(int scale)
+	{
+		// 24-bit (R, G, B) or 32-bit (QRgb) palette of the color table
+		bool rgb888 = (qrgbimg.format() == QImage::Format_RGB888);
+		Ipp8u table24[3 * 256];
+		Ipp32u table32[256];
+		for (int k = 0; k < 256; k++)
 		{
-			int hOffset = 3 * width * i;
-			for (int j = 0; j < width; j++)
+			QRgb val = (k < colortable.size()) ? colortable[k] : qRgb(k, k, k);
+			table24[3 * k + 0] = qRed(val);
+			table24[3 * k + 1] = qGreen(val);
+			table24[3 * k + 2] = qBlue(val);
+			table32[k] = val;
+		}
+		uchar* pRgb = qrgbimg.bits();
+		int rgbStep = qrgbimg.bytesPerLine();
+
+		tbb::parallel_for(tbb::blocked_range<int>(0, height, 16),
+			[&](const tbb::blocked_range<int>& r) {
+			IppiSize roi = { scale * width, (int)r.size() };
+			const Ipp8u* pSrc = arr.raw_ptr() + r.begin() * width;
+			int srcStep = width;
+
+			// Repeated indices for the upscaling
+			np::Uint8Array2 temp;
+			if (scale == 4)
 			{
-				*(qrgbimg.bits() + (3 * j + ch) + hOffset) = *(data + j + hOffset / 3);
+				temp = np::Uint8Array2(4 * width, (int)r.size());
+				for (int i = 0; i < (int)r.size(); i++)
+					repeat4(pSrc + i * width, temp.raw_ptr() + i * 4 * width, width);
+				pSrc = temp.raw_ptr();
+				srcStep = 4 * width;
 			}
-		}
+
+			if (rgb888)
+				ippiLUTPalette_8u24u_C1R(pSrc, srcStep, pRgb + r.begin() * rgbStep, rgbStep, roi, table24, 8);
+			else
+				ippiLUTPalette_8u32u_C1R(pSrc, srcStep, (Ipp32u*)(pRgb + r.begin() * rgbStep), rgbStep, roi, table32, 8);
+		});
+	}
+
+	static void repeat4(const uint8_t* src, uint8_t* dst, int n)
+	{
+		uint32_t* pDst = (uint32_t*)dst;
+		for (int j = 0; j < n; j++)
+			pDst[j] = src[j] * 0x01010101u;
 	}
 
 public:
@@ -6,6 +6,7 @@
 #include <mutex>
 
 #include <Common/Queue.h>
+#include <Common/FrameHeader.h>
 
 template <typename T>
 class SyncObject
@@ -20,9 +21,10 @@ public:
 		n_buffer = n;
         for (int i = 0; i < n_buffer; i++)
         {
-            T* buffer = new T[width * height];
-            memset(buffer, 0, width * height * sizeof(T));
-            queue_buffer.push(buffer);
+            // [FrameHeader][frame data]
+            char* base = new char[sizeof(FrameHeader) + width * height * sizeof(T)];
+            memset(base, 0, sizeof(FrameHeader) + width * height * sizeof(T));
+            queue_buffer.push(reinterpret_cast<T*>(base + sizeof(FrameHeader)));
         }
     }
 
@@ -34,7 +36,7 @@ public:
 			{
 				T* buffer = queue_buffer.front();
 				queue_buffer.pop();
-				delete[] buffer;
+				delete[] reinterpret_cast<char*>(frame_header(buffer));
 			}
 		}
 	}
@@ -6,99 +6,81 @@
 #include <ippcore.h>
 
 #include <chrono>
+#include <cmath>
+#include <vector>
+#include <algorithm>
+#include <map>
+#include <tuple>
+#include <memory>
+#include <mutex>
 #include <tbb/parallel_for.h>
 #include <tbb/blocked_range.h>
 
 #include "array.h"
 
 
+// Polar-to-Cartesian conversion of the rectangular images (8-bit vertical images by a fixed-point LUT)
+// The output diameter can be smaller than the full resolution (the depth is supersampled).
+
 class circularize
 {
+private:
+	struct lut_entry
+	{
+		uint16_t x, y; // top-left source pixel (A-line, depth)
+		uint8_t wx, wy; // bilinear weights (1/256)
+	};
+
+	struct lut_map
+	{
+		int taps; // samples per pixel
+		std::vector<lut_entry> entries;
+		std::vector<int> row_begin, row_end; // columns inside the disk of each row: [begin, end)
+		std::vector<size_t> row_offset; // first entry of each row
+	};
+
+	static const int tile_rows = 16; // rows per parallel task
+	static const int max_taps = 4;
+
 public:
 	circularize()
 	{
         }
 
-	circularize(int _radius, int _alines, bool half = true)
+	circularize(int _radius, int _alines, bool half = true, int _diameter = 0)
 	{
 		radius = _radius;
 		alines = _alines;
+		this->half = half;
+		diameter = (_diameter > 0) ? _diameter : (half ? radius : 2 * radius);
 
-		np::Array<float, 2> x_map, y_map;
-
-		if (half)
-		{
-			// Generate Cicularize Map
-			diameter = radius;
-			x_map = np::Array<float, 2>(diameter, diameter);
-			y_map = np::Array<float, 2>(diameter, diameter);
-			
-			Ipp32f* horizontal_line = ippsMalloc_32f(diameter);
-			Ipp32f* vertical_line = ippsMalloc_32f(diameter);
-			ippsVectorSlope_32f(horizontal_line, diameter, (Ipp32f)+radius, -2.0f);
-
-			for (int i = 0; i < diameter; i++)
-			{
-				ippsSet_32f((float)(2 * i - radius), vertical_line, diameter);
-				memcpy(x_map.raw_ptr() + i * diameter, horizontal_line, sizeof(float) * diameter);
-				memcpy(y_map.raw_ptr() + i * diameter, vertical_line, sizeof(float) * diameter);
-			}
-			ippFree(horizontal_line);
-			ippFree(vertical_line);
-		}
-		else
-		{
-			// Generate Cicularize Map
-			diameter = 2 * radius;
-			x_map = np::Array<float, 2>(diameter, diameter);
-			y_map = np::Array<float, 2>(diameter, diameter);
-
-			Ipp32f* horizontal_line = ippsMalloc_32f(diameter);
-			Ipp32f* vertical_line = ippsMalloc_32f(diameter);
-			ippsVectorSlope_32f(horizontal_line, diameter, (Ipp32f)+radius, -1.0f);
-
-			for (int i = 0; i < diameter; i++)
-			{
-				ippsSet_32f((float)(i - radius), vertical_line, diameter);
-				memcpy(x_map.raw_ptr() + i * diameter, horizontal_line, sizeof(float) * diameter);
-				memcpy(y_map.raw_ptr() + i * diameter, vertical_line, sizeof(float) * diameter);
-			}
-			ippFree(horizontal_line);
-			ippFree(vertical_line);
-		}
-
-		// Rho : Interpolation Map
-		rho = np::Array<float, 2>(diameter, diameter);
-		ippsMagnitude_32f(x_map, y_map, rho, diameter * diameter);
-		ippsMulC_32f_I(((Ipp32f)radius - 1.0f) / radius, rho, diameter * diameter);
-
-		// Theta : Interpolation Map
-		theta = np::Array<float, 2>(diameter, diameter);
-		ippsPhase_32f(x_map, y_map, theta, diameter * diameter);
-		//ippsMulC_32f_I(1.0f, theta, diameter * diameter);
-		ippsAddC_32f_I((Ipp32f)IPP_PI, theta, diameter * diameter);
-		ippsMulC_32f_I(((Ipp32f)alines - 1.0f) / (Ipp32f)IPP_2PI, theta, diameter * diameter);
+		// Polar-to-Cartesian LUT (shared)
+		lut = getLut(radius, alines, half, diameter);
         }
 
 	~circularize()
 	{
 
         }
-	
+
 public:
 	void operator() (np::Array<float, 2>& rect_im, np::Array<float, 2>& circ_im, int offset = 0)
 	{
+		createRemapMaps();
+
 		IppiSize srcSize = { radius, alines }; // width * height
 		IppiRect srcRoi = { 0, 0, radius, alines };
 		IppiSize dstRoiSize = { diameter, diameter };
 
 		ippiRemap_32f_C1R(&rect_im(offset, 0), srcSize, sizeof(Ipp32f) * rect_im.size(0), srcRoi,
 			rho, sizeof(Ipp32f) * dstRoiSize.width, theta, sizeof(Ipp32f) * dstRoiSize.width,
-			circ_im.raw_ptr(), sizeof(Ipp32f) * dstRoiSize.width, dstRoiSize, IPPI_INTER_LINEAR);	
+			circ_im.raw_ptr(), sizeof(Ipp32f) * dstRoiSize.width, dstRoiSize, IPPI_INTER_LINEAR);
         }
 
 	void operator() (np::Array<uint8_t, 2>& rect_im, uint8_t* circ_im, int offset = 0)
 	{
+		createRemapMaps();
+
 		IppiSize srcSize = { radius, alines }; // width * height
 		IppiRect srcRoi = { 0, 0, radius, alines };
 		IppiSize dstRoiSize = { diameter, diameter };
@@ -110,34 +92,195 @@ public:
 
 	void operator() (np::Array<uint8_t, 2>& rect_im, uint8_t* circ_im, const char* vertical, int offset = 0)
 	{
-		IppiSize srcSize = { alines, radius }; // width * height
-		IppiRect srcRoi = { 0, 0, alines, radius };
-		IppiSize dstRoiSize = { diameter, diameter };
-
-		ippiRemap_8u_C1R(&rect_im(0, offset), srcSize, sizeof(Ipp8u) * rect_im.size(0), srcRoi,
-			theta, sizeof(Ipp32f) * dstRoiSize.width, rho, sizeof(Ipp32f) * dstRoiSize.width,
-			circ_im, sizeof(Ipp8u) * dstRoiSize.width, dstRoiSize, IPPI_INTER_LINEAR);
+		remap<1>(&rect_im(0, offset), sizeof(Ipp8u) * rect_im.size(0), circ_im, sizeof(Ipp8u) * diameter);
 
         (void)vertical;
 	}
 
 	void operator() (np::Array<uint8_t, 2>& rect_im, uint8_t* circ_im, const char* vertical, const char* rgb, int offset = 0)
 	{
-		IppiSize srcSize = { alines, radius }; // width * height
-		IppiRect srcRoi = { 0, 0, alines, radius };
-		IppiSize dstRoiSize = { diameter, diameter };
+		remap<3>(&rect_im(0, offset), sizeof(Ipp8u) * rect_im.size(0), circ_im, sizeof(Ipp8u) * 3 * diameter);
 
-		ippiRemap_8u_C3R(&rect_im(0, offset), srcSize, sizeof(Ipp8u) * rect_im.size(0), srcRoi,
-			theta, sizeof(Ipp32f) * dstRoiSize.width, rho, sizeof(Ipp32f) * dstRoiSize.width,
-			circ_im, sizeof(Ipp8u) * 3 * dstRoiSize.width, dstRoiSize, IPPI_INTER_LINEAR);
-		
 		(void)vertical;
 		(void)rgb;
 	}
-		
+
+private:
+	template <int C>
+	void remap(const uint8_t* src, int src_step, uint8_t* dst, int dst_step)
+	{
+		const lut_map& map = *lut;
+
+		// Tiles of rows (only the pixels inside the disk are interpolated)
+		tbb::parallel_for(tbb::blocked_range<int>(0, diameter, tile_rows),
+			[&](const tbb::blocked_range<int>& r) {
+			for (int i = r.begin(); i != r.end(); ++i)
+			{
+				uint8_t* pDst = dst + i * dst_step;
+				int begin = map.row_begin[i], end = map.row_end[i];
+				memset(pDst, 0, C * begin);
+				memset(pDst + C * end, 0, C * (diameter - end));
+
+				const int taps = map.taps;
+				const lut_entry* pLut = &map.entries[0] + map.row_offset[i];
+				for (int j = begin; j < end; j++, pLut += taps)
+				{
+					for (int c = 0; c < C; c++)
+					{
+						uint32_t acc = 0;
+						for (int t = 0; t < taps; t++)
+						{
+							const uint8_t* pSrc = src + pLut[t].y * src_step + pLut[t].x * C + c;
+							uint32_t wx = pLut[t].wx, wy = pLut[t].wy;
+							uint32_t top = pSrc[0] * (256 - wx) + pSrc[C] * wx;
+							uint32_t bottom = pSrc[src_step] * (256 - wx) + pSrc[src_step + C] * wx;
+							acc += top * (256 - wy) + bottom * wy;
+						}
+						pDst[C * j + c] = (uint8_t)((acc + (taps << 15)) / (taps << 16));
+					}
+				}
+			}
+		});
+	}
+
+	static std::shared_ptr<const lut_map> getLut(int radius, int alines, bool half, int diameter)
+	{
+		static std::mutex mtx;
+		static std::map<std::tuple<int, int, bool, int>, std::weak_ptr<const lut_map>> cache;
+
+		std::unique_lock<std::mutex> lock(mtx);
+
+		std::weak_ptr<const lut_map>& cached = cache[std::make_tuple(radius, alines, half, diameter)];
+		std::shared_ptr<const lut_map> map = cached.lock();
+		if (!map)
+		{
+			map = createLut(radius, alines, half, diameter);
+			cached = map;
+		}
+
+		return map;
+	}
+
+	static std::shared_ptr<const lut_map> createLut(int radius, int alines, bool half, int diameter)
+	{
+		// Same geometry as the remap maps: x = theta (A-line), y = rho (depth)
+		double step, shift;
+		getGeometry(radius, half, diameter, step, shift);
+		double rho_scale = ((double)radius - 1.0) / radius;
+		double theta_scale = ((double)alines - 1.0) / IPP_2PI;
+
+		// Supersampling along the radius if downscaled
+		int taps = (int)ceil(step / (half ? 2.0 : 1.0) - 1e-6);
+		taps = std::min(std::max(taps, 1), (int)max_taps);
+
+		std::shared_ptr<lut_map> map = std::make_shared<lut_map>();
+		map->taps = taps;
+		map->row_begin.resize(diameter);
+		map->row_end.resize(diameter);
+		map->row_offset.resize(diameter);
+		map->entries.reserve(((size_t)(IPP_PI * diameter * diameter / 4) + diameter) * taps);
+
+		for (int i = 0; i < diameter; i++)
+		{
+			double y = step * i - radius + shift;
+
+			map->row_offset[i] = map->entries.size();
+			map->row_begin[i] = 0;
+			map->row_end[i] = 0;
+
+			for (int j = 0; j < diameter; j++)
+			{
+				double x = radius - step * j - shift;
+				double r = sqrt(x * x + y * y);
+				if (r * rho_scale > radius - 1) // out of the source image
+					continue;
+				double theta = (atan2(y, x) + IPP_PI) * theta_scale;
+
+				if (map->row_end[i] == 0)
+					map->row_begin[i] = j;
+				map->row_end[i] = j + 1;
+
+				for (int t = 0; t < taps; t++)
+				{
+					double rho = (r + ((t + 0.5) / taps - 0.5) * step) * rho_scale;
+					rho = std::min(std::max(rho, 0.0), (double)radius - 1.0);
+
+					lut_entry entry;
+					toFixedPoint(theta, alines, entry.x, entry.wx);
+					toFixedPoint(rho, radius, entry.y, entry.wy);
+					map->entries.push_back(entry);
+				}
+			}
+		}
+
+		return map;
+	}
+
+	static void getGeometry(int radius, bool half, int diameter, double& step, double& shift)
+	{
+		// Pixel spacing in the source depth & the shift of the pixel centers from the full resolution grid
+		double full_step = half ? 2.0 : 1.0;
+		step = 2.0 * radius / diameter;
+		shift = 0.5 * (step - full_step);
+	}
+
+	static void toFixedPoint(double pos, int len, uint16_t& index, uint8_t& weight)
+	{
+		int i = (int)floor(pos);
+		int w = (int)((pos - i) * 256.0 + 0.5);
+		if (w == 256) { i++; w = 0; }
+		if (i >= len - 1) { i = len - 2; w = 255; } // right (bottom) edge
+
+		index = (uint16_t)i;
+		weight = (uint8_t)w;
+	}
+
+	void createRemapMaps()
+	{
+		static std::mutex mtx;
+		std::unique_lock<std::mutex> lock(mtx);
+
+		if (rho.length() != 0)
+			return;
+
+		// Generate Cicularize Map
+		double step, shift;
+		getGeometry(radius, half, diameter, step, shift);
+
+		np::Array<float, 2> x_map(diameter, diameter);
+		np::Array<float, 2> y_map(diameter, diameter);
+
+		Ipp32f* horizontal_line = ippsMalloc_32f(diameter);
+		Ipp32f* vertical_line = ippsMalloc_32f(diameter);
+		ippsVectorSlope_32f(horizontal_line, diameter, (Ipp32f)(radius - shift), (Ipp32f)-step);
+
+		for (int i = 0; i < diameter; i++)
+		{
+			ippsSet_32f((float)(step * i - radius + shift), vertical_line, diameter);
+			memcpy(x_map.raw_ptr() + i * diameter, horizontal_line, sizeof(float) * diameter);
+			memcpy(y_map.raw_ptr() + i * diameter, vertical_line, sizeof(float) * diameter);
+		}
+		ippFree(horizontal_line);
+		ippFree(vertical_line);
+
+		// Rho : Interpolation Map
+		rho = np::Array<float, 2>(diameter, diameter);
+		ippsMagnitude_32f(x_map, y_map, rho, diameter * diameter);
+		ippsMulC_32f_I(((Ipp32f)radius - 1.0f) / radius, rho, diameter * diameter);
+
+		// Theta : Interpolation Map
+		theta = np::Array<float, 2>(diameter, diameter);
+		ippsPhase_32f(x_map, y_map, theta, diameter * diameter);
+		//ippsMulC_32f_I(1.0f, theta, diameter * diameter);
+		ippsAddC_32f_I((Ipp32f)IPP_PI, theta, diameter * diameter);
+		ippsMulC_32f_I(((Ipp32f)alines - 1.0f) / (Ipp32f)IPP_2PI, theta, diameter * diameter);
+	}
+
 public:
 	int alines, radius, diameter;
 private:
+	bool half;
+	std::shared_ptr<const lut_map> lut;
 	np::Array<float, 2> rho;
 	np::Array<float, 2> theta;
 };
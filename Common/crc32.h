@@ -0,0 +1,56 @@
+#ifndef _CRC32_H_
+#define _CRC32_H_
+
+#include <cstdint>
+#include <cstring>
+
+// CRC-32 (IEEE 802.3, reflected polynomial 0xEDB88320), slicing-by-8
+class crc32
+{
+public:
+	crc32()
+	{
+		for (uint32_t i = 0; i < 256; i++)
+		{
+			uint32_t c = i;
+			for (int k = 0; k < 8; k++)
+				c = (c & 1) ? (0xEDB88320u ^ (c >> 1)) : (c >> 1);
+			table[0][i] = c;
+		}
+		for (uint32_t i = 0; i < 256; i++)
+			for (int t = 1; t < 8; t++)
+				table[t][i] = (table[t - 1][i] >> 8) ^ table[0][table[t - 1][i] & 0xFF];
+	}
+
+	// Continue the checksum with 'crc' of the previous call (0 for the first call)
+	uint32_t operator() (const void* data, size_t length, uint32_t crc = 0) const
+	{
+		const uint8_t* p = static_cast<const uint8_t*>(data);
+		crc = ~crc;
+
+		while (length >= 8)
+		{
+			uint32_t lo, hi;
+			memcpy(&lo, p, 4); memcpy(&hi, p + 4, 4);
+			lo ^= crc;
+			crc = table[7][lo & 0xFF] ^ table[6][(lo >> 8) & 0xFF] ^ table[5][(lo >> 16) & 0xFF] ^ table[4][lo >> 24] ^
+				table[3][hi & 0xFF] ^ table[2][(hi >> 8) & 0xFF] ^ table[1][(hi >> 16) & 0xFF] ^ table[0][hi >> 24];
+			p += 8; length -= 8;
+		}
+		while (length--)
+			crc = table[0][(crc ^ *p++) & 0xFF] ^ (crc >> 8);
+
+		return ~crc;
+	}
+
+	static const crc32& instance()
+	{
+		static const crc32 _crc;
+		return _crc;
+	}
+
+private:
+	uint32_t table[8][256];
+};
+
+#endif
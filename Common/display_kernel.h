@@ -0,0 +1,102 @@
+#ifndef _DISPLAY_KERNEL_H_
+#define _DISPLAY_KERNEL_H_
+
+#include <cstdint>
+#include <cstring>
+#include <algorithm>
+#include <cfloat>
+#include <vector>
+#include <tbb/parallel_for.h>
+#include <tbb/blocked_range.h>
+
+#include "medfilt.h"
+
+
+// Display preprocessing of an OCT image in a pass: scaling (dB -> 8-bit), circShift, transpose, galvo shift and
+// 3x3 median filtering (replicated border)
+
+class display_kernel
+{
+private:
+	static const int tile_rows = 16; // depth rows per parallel task
+
+public:
+	display_kernel()
+	{
+	}
+
+	display_kernel(int _depth, int _alines, bool _median = true) :
+		depth(_depth), alines(_alines), median(_median)
+	{
+	}
+
+	~display_kernel()
+	{
+	}
+
+public:
+	// res: depth x alines (float dB), rect_im: alines x depth (8-bit, transposed)
+	// Depth [0, circ_shift) is 0, and the A-lines are rotated left by galvo_shift.
+	void operator() (const float* res, uint8_t* rect_im, float db_min, float db_max, int circ_shift = 0, int galvo_shift = 0) const
+	{
+		float scale = 255.0f / std::max(db_max - db_min, FLT_EPSILON);
+		circ_shift = std::min(std::max(circ_shift, 0), depth);
+		galvo_shift = ((galvo_shift % alines) + alines) % alines;
+
+		tbb::parallel_for(tbb::blocked_range<int>(0, (depth + tile_rows - 1) / tile_rows),
+			[&](const tbb::blocked_range<int>& r) {
+			const int padded = alines + 2; // replicated border pixels for the median
+			std::vector<uint8_t> buffer((tile_rows + 2) * padded);
+			std::vector<uint8_t> sorted(3 * padded);
+
+			for (int t = r.begin(); t != r.end(); ++t)
+			{
+				int row0 = t * tile_rows;
+				int row1 = std::min(row0 + tile_rows, depth);
+				int nRows = row1 - row0 + 2; // including the rows above & below (replicated at the border)
+
+				// Scaling, circShift, transpose & galvo shift (rows row0 - 1 ... row1 of the result)
+				for (int j = 0; j < alines; j++)
+				{
+					int src_aline = j + galvo_shift;
+					if (src_aline >= alines) src_aline -= alines;
+					const float* pSrc = res + (size_t)src_aline * depth;
+
+					for (int k = 0; k < nRows; k++)
+					{
+						int i = std::min(std::max(row0 - 1 + k, 0), depth - 1);
+						uint8_t value = 0;
+						if (i >= circ_shift)
+						{
+							float v = (pSrc[i - circ_shift] - db_min) * scale + 0.5f;
+							value = (uint8_t)std::min(std::max(v, 0.0f), 255.0f);
+						}
+						buffer[k * padded + 1 + j] = value;
+					}
+				}
+				for (int k = 0; k < nRows; k++)
+				{
+					buffer[k * padded] = buffer[k * padded + 1];
+					buffer[k * padded + alines + 1] = buffer[k * padded + alines];
+				}
+
+				// Median filtering
+				for (int i = row0; i < row1; i++)
+				{
+					const uint8_t* pRow = &buffer[(i - row0) * padded + 1];
+					uint8_t* pDst = rect_im + (size_t)i * alines;
+					if (median)
+						medfilt::median3x3_row(pRow, pRow + padded, pRow + 2 * padded, pDst, alines, &sorted[0]);
+					else
+						memcpy(pDst, pRow + padded, sizeof(uint8_t) * alines);
+				}
+			}
+		});
+	}
+
+public:
+	int depth, alines;
+	bool median;
+};
+
+#endif
@@ -0,0 +1,294 @@
+#ifndef _FRINGE_CODEC_H_
+#define _FRINGE_CODEC_H_
+
+#include <iostream>
+#include <algorithm>
+#include <atomic>
+#include <vector>
+#include <cstring>
+#include <cstdint>
+
+#include <tbb/parallel_for.h>
+#include <tbb/blocked_range.h>
+
+#include "array.h"
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+// Lossless codec for raw fringe frames (nScans x nAlines, uint16), coded in independent blocks of A-lines
+// Frame layout: [uint32 nBlocks][uint32 blockBytes x nBlocks][block payloads...]
+
+#define FRINGE_CODEC_BLOCK_ALINES	16
+#define FRINGE_CODEC_ESCAPE			16 // Unary prefix length of the escape code
+#define FRINGE_CODEC_RAW_BITS		17 // Zigzag residual of uint16 difference fits in 17 bits
+
+
+class fringe_codec
+{
+public:
+	fringe_codec()
+	{
+	}
+
+	fringe_codec(int _nScans, int _nAlines, int _blockAlines = FRINGE_CODEC_BLOCK_ALINES) :
+		nScans(_nScans), nAlines(_nAlines), blockAlines(_blockAlines)
+	{
+		nBlocks = (nAlines + blockAlines - 1) / blockAlines;
+		blockBound = blockAlines * (nScans * (FRINGE_CODEC_ESCAPE + FRINGE_CODEC_RAW_BITS) + 8) / 8 + 16;
+
+		scratch = np::Array<uint8_t, 2>(blockBound, nBlocks);
+		blockBytes = std::vector<uint32_t>(nBlocks);
+	}
+
+	~fringe_codec()
+	{
+	}
+
+public:
+	// Maximum size of a compressed frame (worst case: every residual escaped)
+	int bound() const { return (int)(sizeof(uint32_t) * (1 + nBlocks)) + blockBound * nBlocks; }
+
+	// Returns the number of bytes written to dst (dst should be at least bound() bytes)
+	int encode(const uint16_t* src, uint8_t* dst)
+	{
+		tbb::parallel_for(tbb::blocked_range<size_t>(0, (size_t)nBlocks),
+			[&](const tbb::blocked_range<size_t>& r) {
+			for (size_t i = r.begin(); i != r.end(); ++i)
+				blockBytes[i] = encodeBlock(src, (int)i, &scratch(0, (int)i));
+		});
+
+		// Block table & payloads
+		uint32_t* table = reinterpret_cast<uint32_t*>(dst);
+		table[0] = (uint32_t)nBlocks;
+		memcpy(table + 1, blockBytes.data(), sizeof(uint32_t) * nBlocks);
+
+		uint8_t* payload = dst + sizeof(uint32_t) * (1 + nBlocks);
+		for (int i = 0; i < nBlocks; i++)
+		{
+			memcpy(payload, &scratch(0, i), blockBytes[i]);
+			payload += blockBytes[i];
+		}
+
+		return (int)(payload - dst);
+	}
+
+	// Returns false if the compressed frame is corrupted or does not match the frame size
+	bool decode(const uint8_t* src, int size, uint16_t* dst)
+	{
+		if (size < (int)(sizeof(uint32_t) * (1 + nBlocks))) return false;
+
+		const uint32_t* table = reinterpret_cast<const uint32_t*>(src);
+		if (table[0] != (uint32_t)nBlocks) return false;
+
+		// Offsets are increasing & in [header, size] (a corrupted table is rejected before decoding)
+		std::vector<int> offsets(nBlocks + 1);
+		int64_t offset = (int64_t)(sizeof(uint32_t) * (1 + nBlocks));
+		offsets[0] = (int)offset;
+		for (int i = 0; i < nBlocks; i++)
+		{
+			if ((int64_t)table[1 + i] > (int64_t)size - offset) return false;
+			offset += table[1 + i];
+			offsets[i + 1] = (int)offset;
+		}
+
+		std::atomic<bool> valid(true);
+		tbb::parallel_for(tbb::blocked_range<size_t>(0, (size_t)nBlocks),
+			[&](const tbb::blocked_range<size_t>& r) {
+			for (size_t i = r.begin(); i != r.end(); ++i)
+				if (!decodeBlock(src + offsets[i], offsets[i + 1] - offsets[i], (int)i, dst))
+					valid = false;
+		});
+
+		return valid;
+	}
+
+private:
+	static inline uint32_t zigzag(int32_t v) { return ((uint32_t)v << 1) ^ (uint32_t)(v >> 31); }
+	static inline int32_t unzigzag(uint32_t v) { return (int32_t)(v >> 1) ^ -(int32_t)(v & 1); }
+
+	static inline int riceParameter(uint64_t sum, int n)
+	{
+		// k = floor(log2(mean residual))
+		int k = 0;
+		while (k < 15 && ((uint64_t)n << (k + 1)) <= sum) k++;
+		return k;
+	}
+
+	struct bit_writer
+	{
+		bit_writer(uint8_t* _ptr) : ptr(_ptr), start(_ptr), acc(0), nbits(0) {}
+
+		inline void put(uint32_t bits, int n) // n <= 32
+		{
+			acc |= (uint64_t)bits << nbits;
+			nbits += n;
+			while (nbits >= 8)
+			{
+				*ptr++ = (uint8_t)acc;
+				acc >>= 8;
+				nbits -= 8;
+			}
+		}
+
+		inline int flush()
+		{
+			if (nbits > 0) *ptr++ = (uint8_t)acc;
+			acc = 0; nbits = 0;
+			return (int)(ptr - start);
+		}
+
+		uint8_t* ptr;
+		uint8_t* start;
+		uint64_t acc;
+		int nbits;
+	};
+
+	struct bit_reader
+	{
+		bit_reader(const uint8_t* _ptr, int _size) : ptr(_ptr), end(_ptr + _size), size(_size), acc(0), nbits(0), fed(0) {}
+
+		inline void refill()
+		{
+			while (nbits <= 56)
+			{
+				uint64_t byte = (ptr < end) ? *ptr++ : 0; // zero padding beyond the end
+				acc |= byte << nbits;
+				nbits += 8;
+				fed++;
+			}
+		}
+
+		inline uint32_t get(int n) // n <= 32
+		{
+			if (nbits < n) refill();
+			uint32_t bits = (uint32_t)(acc & ((1ull << n) - 1));
+			acc >>= n; nbits -= n;
+			return bits;
+		}
+
+		inline int ones() // Number of consecutive 1 bits (up to escape), consumes the terminating 0
+		{
+			if (nbits < FRINGE_CODEC_ESCAPE + 1) refill();
+			uint32_t inv = (uint32_t)~acc & ((1u << (FRINGE_CODEC_ESCAPE + 1)) - 1);
+			int q = ctz(inv | (1u << FRINGE_CODEC_ESCAPE));
+			if (q >= FRINGE_CODEC_ESCAPE) { acc >>= FRINGE_CODEC_ESCAPE; nbits -= FRINGE_CODEC_ESCAPE; return FRINGE_CODEC_ESCAPE; }
+			acc >>= (q + 1); nbits -= (q + 1);
+			return q;
+		}
+
+		// True if more bits were consumed than the block contains
+		bool overrun() const { return 8 * fed - nbits > 8 * size; }
+
+		static inline int ctz(uint32_t v)
+		{
+#ifdef _MSC_VER
+			unsigned long idx; _BitScanForward(&idx, v); return (int)idx;
+#else
+			return __builtin_ctz(v);
+#endif
+		}
+
+		const uint8_t* ptr;
+		const uint8_t* end;
+		int64_t size;
+		uint64_t acc;
+		int nbits;
+		int64_t fed;
+	};
+
+	int encodeBlock(const uint16_t* src, int block, uint8_t* dst)
+	{
+		int a0 = block * blockAlines;
+		int a1 = std::min(a0 + blockAlines, nAlines);
+
+		bit_writer bw(dst);
+		std::vector<uint32_t> res(nScans);
+
+		for (int a = a0; a < a1; a++)
+		{
+			const uint16_t* line = src + (size_t)a * nScans;
+			const uint16_t* prev = line - nScans;
+
+			// 1. Prediction & zigzag mapping
+			uint64_t sum = 0;
+			if (a == a0)
+			{
+				int32_t last = 0;
+				for (int i = 0; i < nScans; i++)
+				{
+					res[i] = zigzag((int32_t)line[i] - last);
+					last = line[i];
+					sum += res[i];
+				}
+			}
+			else
+			{
+				for (int i = 0; i < nScans; i++)
+				{
+					res[i] = zigzag((int32_t)line[i] - (int32_t)prev[i]);
+					sum += res[i];
+				}
+			}
+
+			// 2. Rice coding
+			int k = riceParameter(sum, nScans);
+			bw.put((uint32_t)k, 4);
+			for (int i = 0; i < nScans; i++)
+			{
+				uint32_t q = res[i] >> k;
+				if (q < FRINGE_CODEC_ESCAPE)
+				{
+					bw.put((1u << q) - 1, (int)q + 1); // q ones followed by a zero
+					if (k) bw.put(res[i] & ((1u << k) - 1), k);
+				}
+				else
+				{
+					bw.put((1u << FRINGE_CODEC_ESCAPE) - 1, FRINGE_CODEC_ESCAPE);
+					bw.put(res[i], FRINGE_CODEC_RAW_BITS);
+				}
+			}
+		}
+
+		return bw.flush();
+	}
+
+	bool decodeBlock(const uint8_t* src, int size, int block, uint16_t* dst)
+	{
+		int a0 = block * blockAlines;
+		int a1 = std::min(a0 + blockAlines, nAlines);
+
+		bit_reader br(src, size);
+
+		for (int a = a0; a < a1; a++)
+		{
+			uint16_t* line = dst + (size_t)a * nScans;
+			const uint16_t* prev = line - nScans;
+
+			int k = (int)br.get(4);
+			int32_t last = 0;
+			for (int i = 0; i < nScans; i++)
+			{
+				uint32_t q = (uint32_t)br.ones();
+				uint32_t v = (q < FRINGE_CODEC_ESCAPE) ? ((q << k) | (k ? br.get(k) : 0)) : br.get(FRINGE_CODEC_RAW_BITS);
+				int32_t pred = (a == a0) ? last : (int32_t)prev[i];
+				last = pred + unzigzag(v);
+				line[i] = (uint16_t)last;
+			}
+		}
+
+		return !br.overrun();
+	}
+
+public:
+	int nScans, nAlines, blockAlines;
+	int nBlocks;
+
+private:
+	int blockBound;
+	np::Array<uint8_t, 2> scratch;
+	std::vector<uint32_t> blockBytes;
+};
+
+#endif
@@ -1,8 +1,26 @@
 #ifndef _MEDFILT_H_
 #define _MEDFILT_H_
 
+#include <ipps.h>
+#include <ippi.h>
+
+#include <cstring>
+#include <vector>
+#include <algorithm>
+#include <tbb/parallel_for.h>
+#include <tbb/blocked_range.h>
+
+#include "array.h"
+
+
+// Median filter (replicated border) of 8u & 32f images (3x3 & 5x5 by sorting networks, others by IPP)
+
 class medfilt
 {
+private:
+	static const int tile_rows = 32; // rows per parallel task
+	static const int chunk = 256; // pixels per pass of the 5x5 network (the lanes fit in L1)
+
 public:
 	medfilt()
 	{
@@ -14,13 +32,16 @@ public:
 		RoiSize = { width, height };
 		MaskSize = { kernelx, kernely };
 
-		ippiFilterMedianBorderGetBufferSize(RoiSize, MaskSize, ipp8u, 1, &BufferSize);
-		MemBuffer8u = np::Array<uint8_t>(BufferSize);
-		DstBuffer8u = np::Array<Ipp8u, 2>(width, height);
+		if (!isNetwork())
+		{
+			ippiFilterMedianBorderGetBufferSize(RoiSize, MaskSize, ipp8u, 1, &BufferSize);
+			MemBuffer8u = np::Array<uint8_t>(BufferSize);
+			DstBuffer8u = np::Array<Ipp8u, 2>(width, height);
 
-		ippiFilterMedianBorderGetBufferSize(RoiSize, MaskSize, ipp32f, 1, &BufferSize);
-		MemBuffer32f = np::Array<uint8_t>(BufferSize);
-		DstBuffer32f = np::Array<Ipp32f, 2>(width, height);
+			ippiFilterMedianBorderGetBufferSize(RoiSize, MaskSize, ipp32f, 1, &BufferSize);
+			MemBuffer32f = np::Array<uint8_t>(BufferSize);
+			DstBuffer32f = np::Array<Ipp32f, 2>(width, height);
+		}
 	};
 
 	~medfilt()
@@ -29,16 +50,194 @@ public:
 
 	void operator() (Ipp8u* pSrcDst)
 	{
-		ippiFilterMedianBorder_8u_C1R(pSrcDst, sizeof(Ipp8u) * RoiSize.width, DstBuffer8u, sizeof(Ipp8u) * RoiSize.width, RoiSize, MaskSize, ippBorderRepl, 0, MemBuffer8u);
-		memcpy(pSrcDst, DstBuffer8u, sizeof(Ipp8u) * width * height);
+		if (isNetwork())
+			filter(pSrcDst);
+		else
+		{
+			ippiFilterMedianBorder_8u_C1R(pSrcDst, sizeof(Ipp8u) * RoiSize.width, DstBuffer8u, sizeof(Ipp8u) * RoiSize.width, RoiSize, MaskSize, ippBorderRepl, 0, MemBuffer8u);
+			memcpy(pSrcDst, DstBuffer8u, sizeof(Ipp8u) * width * height);
+		}
 	};
 
 	void operator() (Ipp32f* pSrcDst)
 	{
-		ippiFilterMedianBorder_32f_C1R(pSrcDst, sizeof(Ipp32f) * RoiSize.width, DstBuffer32f, sizeof(Ipp32f) * RoiSize.width, RoiSize, MaskSize, ippBorderRepl, 0, MemBuffer32f);
-		memcpy(pSrcDst, DstBuffer32f, sizeof(Ipp32f) * width * height);
+		if (isNetwork())
+			filter(pSrcDst);
+		else
+		{
+			ippiFilterMedianBorder_32f_C1R(pSrcDst, sizeof(Ipp32f) * RoiSize.width, DstBuffer32f, sizeof(Ipp32f) * RoiSize.width, RoiSize, MaskSize, ippBorderRepl, 0, MemBuffer32f);
+			memcpy(pSrcDst, DstBuffer32f, sizeof(Ipp32f) * width * height);
+		}
 	};
 
+public:
+	// A row of the 3x3 median: r0, r1, r2 are padded by a pixel on both sides (r[-1] & r[n] are valid).
+	// sorted: buffer of 3 * (n + 2)
+	template <typename T>
+	static void median3x3_row(const T* r0, const T* r1, const T* r2, T* dst, int n, T* sorted)
+	{
+		// 1. Sorted columns (low, middle, high)
+		T* lo = sorted;
+		T* mid = sorted + (n + 2);
+		T* hi = sorted + 2 * (n + 2);
+		for (int j = 0; j < n + 2; j++)
+		{
+			T a = vmin(r0[j - 1], r1[j - 1]), b = vmax(r0[j - 1], r1[j - 1]), c = r2[j - 1];
+			lo[j] = vmin(a, c);
+			hi[j] = vmax(b, c);
+			mid[j] = vmax(a, vmin(b, c));
+		}
+
+		// 2. Median of the neighboring columns
+		for (int j = 0; j < n; j++)
+			dst[j] = vmed(vmax(vmax(lo[j], lo[j + 1]), lo[j + 2]), vmed(mid[j], mid[j + 1], mid[j + 2]), vmin(vmin(hi[j], hi[j + 1]), hi[j + 2]));
+	}
+
+	// A row of the 5x5 median: rows[0...4] are padded by 2 pixels on both sides.
+	// lanes: buffer of 25 * chunk
+	template <typename T>
+	static void median5x5_row(const T* const* rows, T* dst, int n, T* lanes)
+	{
+		const signed char (*net)[3] = network25();
+
+		for (int j0 = 0; j0 < n; j0 += chunk)
+		{
+			int m = std::min((int)chunk, n - j0);
+
+			// Lanes: the 25 pixels of the mask for the pixels of the chunk
+			for (int k = 0; k < 25; k++)
+				memcpy(lanes + k * chunk, rows[k / 5] + j0 + (k % 5) - 2, sizeof(T) * m);
+
+			for (int c = 0; c < nComparators25; c++)
+			{
+				T* a = lanes + net[c][0] * chunk;
+				T* b = lanes + net[c][1] * chunk;
+				switch (net[c][2])
+				{
+				case 0: // both
+					for (int j = 0; j < m; j++)
+					{
+						T x = a[j], y = b[j];
+						a[j] = vmin(x, y);
+						b[j] = vmax(x, y);
+					}
+					break;
+				case 1: // only the lower one is used
+					for (int j = 0; j < m; j++)
+						a[j] = vmin(a[j], b[j]);
+					break;
+				default: // only the upper one is used
+					for (int j = 0; j < m; j++)
+						b[j] = vmax(a[j], b[j]);
+					break;
+				}
+			}
+
+			memcpy(dst + j0, lanes + 12 * chunk, sizeof(T) * m);
+		}
+	}
+
+private:
+	bool isNetwork() const { return (kernelx == kernely) && ((kernelx == 3) || (kernelx == 5)); }
+
+	template <typename T>
+	void filter(T* img)
+	{
+		const int r = kernelx / 2;
+		const int nRing = 2 * r + 1;
+		const int padded = width + 2 * r;
+		const int nTiles = (height + tile_rows - 1) / tile_rows;
+
+		// Source rows around the tile boundaries: [a - r, a + r) of the boundary a
+		std::vector<T> halo((size_t)std::max(nTiles - 1, 0) * 2 * r * width);
+		for (int t = 1; t < nTiles; t++)
+		{
+			int a = t * tile_rows;
+			for (int k = 0; k < 2 * r; k++)
+			{
+				int i = std::min(a - r + k, height - 1);
+				memcpy(&halo[((size_t)(t - 1) * 2 * r + k) * width], img + (size_t)i * width, sizeof(T) * width);
+			}
+		}
+
+		tbb::parallel_for(tbb::blocked_range<int>(0, nTiles),
+			[&](const tbb::blocked_range<int>& range) {
+			std::vector<T> ring((size_t)nRing * padded);
+			std::vector<T> temp((r == 1) ? 3 * (width + 2) : 25 * chunk);
+			const T* rows[5];
+
+			for (int t = range.begin(); t != range.end(); ++t)
+			{
+				int a = t * tile_rows;
+				int b = std::min(a + tile_rows, height);
+
+				// Source row (the rows of the neighbor tiles from the halo)
+				auto source = [&](int i) -> const T* {
+					i = std::min(std::max(i, 0), height - 1);
+					if (i < a)
+						return &halo[((size_t)(t - 1) * 2 * r + (i - (a - r))) * width];
+					if (i >= b)
+						return &halo[((size_t)t * 2 * r + (i - (b - r))) * width];
+					return img + (size_t)i * width;
+				};
+
+				// Rolling line buffer (padded with the border pixels)
+				auto load = [&](int i) {
+					T* pRow = &ring[(size_t)(((i % nRing) + nRing) % nRing) * padded];
+					memcpy(pRow + r, source(i), sizeof(T) * width);
+					for (int k = 0; k < r; k++)
+					{
+						pRow[k] = pRow[r];
+						pRow[r + width + k] = pRow[r + width - 1];
+					}
+				};
+
+				for (int i = a - r; i < a + r; i++)
+					load(i);
+
+				for (int i = a; i < b; i++)
+				{
+					load(i + r);
+					for (int k = 0; k < nRing; k++)
+						rows[k] = &ring[(size_t)((((i - r + k) % nRing) + nRing) % nRing) * padded] + r;
+
+					if (r == 1)
+						median3x3_row(rows[0], rows[1], rows[2], img + (size_t)i * width, width, &temp[0]);
+					else
+						median5x5_row(rows, img + (size_t)i * width, width, &temp[0]);
+				}
+			}
+		});
+	}
+
+	template <typename T> static inline T vmin(T a, T b) { return (b < a) ? b : a; }
+	template <typename T> static inline T vmax(T a, T b) { return (a < b) ? b : a; }
+	template <typename T> static inline T vmed(T a, T b, T c) { return vmax(vmin(a, b), vmin(vmax(a, b), c)); }
+
+	static const int nComparators25 = 113;
+	static const signed char (*network25())[3]
+	{
+		// (lower wire, upper wire, 0: both / 1: lower only / 2: upper only), median at wire 12
+		static const signed char net[nComparators25][3] = {
+			{ 0, 1, 0 }, { 2, 3, 0 }, { 4, 5, 0 }, { 6, 7, 0 }, { 8, 9, 0 }, { 10, 11, 0 }, { 12, 13, 0 }, { 14, 15, 0 },
+			{ 16, 17, 0 }, { 18, 19, 0 }, { 20, 21, 0 }, { 22, 23, 0 }, { 0, 2, 0 }, { 1, 3, 0 }, { 4, 6, 0 }, { 5, 7, 0 },
+			{ 8, 10, 0 }, { 9, 11, 0 }, { 12, 14, 0 }, { 13, 15, 0 }, { 16, 18, 0 }, { 17, 19, 0 }, { 20, 22, 0 }, { 21, 23, 0 },
+			{ 1, 2, 0 }, { 5, 6, 0 }, { 9, 10, 0 }, { 13, 14, 0 }, { 17, 18, 0 }, { 21, 22, 0 }, { 0, 4, 0 }, { 1, 5, 0 },
+			{ 2, 6, 0 }, { 3, 7, 0 }, { 8, 12, 0 }, { 9, 13, 0 }, { 10, 14, 0 }, { 11, 15, 0 }, { 16, 20, 0 }, { 17, 21, 0 },
+			{ 18, 22, 0 }, { 19, 23, 0 }, { 2, 4, 0 }, { 3, 5, 0 }, { 10, 12, 0 }, { 11, 13, 0 }, { 18, 20, 0 }, { 19, 21, 0 },
+			{ 1, 2, 0 }, { 3, 4, 0 }, { 5, 6, 0 }, { 9, 10, 0 }, { 11, 12, 0 }, { 13, 14, 0 }, { 17, 18, 0 }, { 19, 20, 0 },
+			{ 21, 22, 0 }, { 0, 8, 0 }, { 1, 9, 0 }, { 2, 10, 0 }, { 3, 11, 0 }, { 4, 12, 0 }, { 5, 13, 0 }, { 6, 14, 0 },
+			{ 7, 15, 1 }, { 16, 24, 0 }, { 4, 8, 0 }, { 5, 9, 0 }, { 6, 10, 0 }, { 7, 11, 0 }, { 20, 24, 0 }, { 2, 4, 0 },
+			{ 3, 5, 0 }, { 6, 8, 0 }, { 7, 9, 0 }, { 10, 12, 0 }, { 11, 13, 0 }, { 18, 20, 0 }, { 19, 21, 0 }, { 22, 24, 0 },
+			{ 1, 2, 0 }, { 3, 4, 0 }, { 5, 6, 0 }, { 7, 8, 0 }, { 9, 10, 0 }, { 11, 12, 0 }, { 13, 14, 1 }, { 17, 18, 0 },
+			{ 19, 20, 0 }, { 21, 22, 0 }, { 23, 24, 0 }, { 0, 16, 2 }, { 1, 17, 2 }, { 2, 18, 2 }, { 3, 19, 2 }, { 4, 20, 2 },
+			{ 5, 21, 2 }, { 6, 22, 1 }, { 7, 23, 1 }, { 8, 24, 1 }, { 8, 16, 2 }, { 9, 17, 2 }, { 10, 18, 1 }, { 11, 19, 1 },
+			{ 12, 20, 1 }, { 13, 21, 1 }, { 6, 10, 2 }, { 7, 11, 2 }, { 12, 16, 1 }, { 13, 17, 1 }, { 10, 12, 2 }, { 11, 13, 1 },
+			{ 11, 12, 2 }
+		};
+		return net;
+	}
+
 private:
 	int width, height, kernelx, kernely;
 	IppiSize RoiSize, MaskSize;
@@ -0,0 +1,249 @@
+
+#include "EnFaceProjection.h"
+
+#include <ipps.h>
+
+#include <tbb/parallel_for.h>
+#include <tbb/blocked_range.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+
+EnFaceProjection::EnFaceProjection() :
+	m_nAlines(0), m_nFrames(0), m_nBlocks(0), m_blockStart(0), m_offset(0), m_stat(maximum)
+{
+}
+
+EnFaceProjection::~EnFaceProjection()
+{
+	clear();
+}
+
+
+void EnFaceProjection::allocate(int nAlines, int nFrames, int offset)
+{
+	clear();
+
+	m_nAlines = nAlines;
+	m_nFrames = nFrames;
+	m_offset = std::max(offset, 0);
+
+	// Depth blocks from the block boundary before the shallowest window
+	m_blockStart = (PROJECTION_OFFSET / PROJECTION_BLOCK) * PROJECTION_BLOCK;
+	m_nBlocks = (CIRC_RADIUS - m_blockStart + PROJECTION_BLOCK - 1) / PROJECTION_BLOCK;
+
+	m_blocks.resize((size_t)nFrames * nAlines * m_nBlocks);
+	std::vector<std::atomic<bool>>(nFrames).swap(m_processed);
+	m_percentileOffset.assign(nFrames, -1);
+
+	for (int i = 0; i < nStatistics; i++)
+	{
+		m_proj[i] = np::FloatArray2(nAlines, nFrames);
+		memset(m_proj[i].raw_ptr(), 0, sizeof(float) * m_proj[i].length());
+	}
+}
+
+void EnFaceProjection::clear()
+{
+	std::vector<Block>().swap(m_blocks);
+	m_processed.clear();
+	m_percentileOffset.clear();
+
+	m_nAlines = 0;
+	m_nFrames = 0;
+}
+
+
+void EnFaceProjection::processFrame(const OctVolume::Frame& octImage, int frame)
+{
+	// 1. Blocks of each A-line (single pass)
+	for (int j = 0; j < m_nAlines; j++)
+	{
+		Block* pBlocks = blocks(frame, j);
+		for (int b = 0; b < m_nBlocks; b++)
+		{
+			int start = m_blockStart + b * PROJECTION_BLOCK;
+			getBlock(&octImage(start, j), std::min(PROJECTION_BLOCK, CIRC_RADIUS - start), pBlocks[b]);
+		}
+	}
+
+	// 2. Statistics of the window (projected again if the offset has been changed meanwhile)
+	int offset = m_offset;
+	for (;;)
+	{
+		project(frame, offset, &octImage, true);
+
+		std::unique_lock<std::mutex> lock(m_mtxOffset);
+		if (offset == m_offset)
+		{
+			m_processed[frame] = true;
+			break;
+		}
+		offset = m_offset;
+	}
+}
+
+
+void EnFaceProjection::setOffset(int offset, OctVolume& octVolume, const std::function<bool(int)>& isReady)
+{
+	{
+		std::unique_lock<std::mutex> lock(m_mtxOffset);
+		m_offset = std::max(offset, 0);
+	}
+	update(octVolume, isReady, true);
+}
+
+void EnFaceProjection::setStatistic(statistic stat, OctVolume& octVolume, const std::function<bool(int)>& isReady)
+{
+	m_stat = stat;
+	update(octVolume, isReady, false);
+}
+
+
+QString EnFaceProjection::name(statistic stat)
+{
+	switch (stat)
+	{
+	case maximum: return "max";
+	case mean: return "mean";
+	case minimum: return "min";
+	case stdev: return "std";
+	case percentile: return QString("p%1").arg(PROJECTION_PERCENTILE);
+	}
+	return "";
+}
+
+
+void EnFaceProjection::getBlock(const OctVolume::value_type* src, int len, Block& block)
+{
+#ifdef OCT_DB_FIXED_POINT
+	Ipp32s sum;
+	Ipp64s sumsq;
+	ippsMinMax_16s(src, len, &block.min, &block.max);
+	ippsSum_16s32s_Sfs(src, len, &sum, 0);
+	ippsDotProd_16s64s(src, src, len, &sumsq);
+
+	// Exact in integer (sum of squared deviations = (n * sumsq - sum^2) / n)
+	const double scale = 1.0 / (double)(1 << OCT_DB_FRAC_BITS);
+	block.sum = (float)(sum * scale);
+	block.m2 = (float)((double)((Ipp64s)len * sumsq - (Ipp64s)sum * sum) / len * scale * scale);
+#else
+	Ipp32f sum;
+	Ipp64f sumsq;
+	ippsMinMax_32f(src, len, &block.min, &block.max);
+	ippsSum_32f(src, len, &sum, ippAlgHintFast);
+	ippsDotProd_32f64f(src, src, len, &sumsq);
+	block.sum = sum;
+	block.m2 = (float)std::max(sumsq - (double)sum * sum / len, 0.0);
+#endif
+}
+
+void EnFaceProjection::project(int frame, int offset, const OctVolume::Frame* pImage, bool withPercentile)
+{
+	// Window: head in the first block (read from the image) + the following blocks
+	int start = offset + PROJECTION_OFFSET;
+	int len = CIRC_RADIUS - start;
+	int firstBlock = std::max(start - m_blockStart + PROJECTION_BLOCK - 1, 0) / PROJECTION_BLOCK;
+	int headEnd = std::min(m_blockStart + firstBlock * PROJECTION_BLOCK, CIRC_RADIUS);
+
+	std::vector<OctVolume::value_type> window(withPercentile ? std::max(len, 0) : 0);
+	int rank = (std::max(len, 1) - 1) * PROJECTION_PERCENTILE / 100;
+
+	for (int j = 0; j < m_nAlines; j++)
+	{
+		if (len <= 0)
+		{
+			for (int s = 0; s < nStatistics; s++)
+				m_proj[s](j, frame) = 0.0f;
+			continue;
+		}
+
+		// Pairwise combination of the blocks (n: samples, sum, m2: sum of squared deviations)
+		Block acc;
+		int n = 0;
+		double sum = 0.0, m2 = 0.0;
+
+		if (headEnd > start)
+		{
+			n = headEnd - start;
+			getBlock(&(*pImage)(start, j), n, acc);
+			sum = acc.sum; m2 = acc.m2;
+		}
+
+		const Block* pBlocks = blocks(frame, j);
+		for (int b = firstBlock; b < m_nBlocks; b++)
+		{
+			const Block& block = pBlocks[b];
+			int nb = std::min(PROJECTION_BLOCK, CIRC_RADIUS - (m_blockStart + b * PROJECTION_BLOCK));
+			if (n == 0)
+			{
+				acc = block;
+				sum = block.sum; m2 = block.m2;
+			}
+			else
+			{
+				double delta = (double)block.sum / nb - sum / n;
+				m2 += block.m2 + delta * delta * n * nb / (n + nb);
+				sum += block.sum;
+				acc.max = std::max(acc.max, block.max);
+				acc.min = std::min(acc.min, block.min);
+			}
+			n += nb;
+		}
+
+		m_proj[maximum](j, frame) = OctVolume::toDb(acc.max);
+		m_proj[minimum](j, frame) = OctVolume::toDb(acc.min);
+		m_proj[mean](j, frame) = (float)(sum / len);
+		m_proj[stdev](j, frame) = (float)sqrt(std::max(m2 / len, 0.0));
+
+		if (withPercentile)
+		{
+			memcpy(window.data(), &(*pImage)(start, j), sizeof(OctVolume::value_type) * len);
+			std::nth_element(window.begin(), window.begin() + rank, window.end());
+			m_proj[percentile](j, frame) = OctVolume::toDb(window[rank]);
+		}
+	}
+
+	if (withPercentile)
+		m_percentileOffset[frame] = offset;
+}
+
+void EnFaceProjection::update(OctVolume& octVolume, const std::function<bool(int)>& isReady, bool reproject)
+{
+	int offset = m_offset;
+	int start = offset + PROJECTION_OFFSET;
+	bool aligned = (start >= CIRC_RADIUS) || ((start >= m_blockStart) && ((start - m_blockStart) % PROJECTION_BLOCK == 0)); // no head read from the image
+	bool withPercentile = (m_stat == percentile);
+
+	tbb::parallel_for(tbb::blocked_range<size_t>(0, (size_t)m_nFrames),
+		[&](const tbb::blocked_range<size_t>& r) {
+		for (size_t i = r.begin(); i != r.end(); ++i)
+		{
+			int frame = (int)i;
+			if (m_processed[frame])
+			{
+				// Combined from the blocks (frames are read for the head or the percentile)
+				bool needPercentile = withPercentile && (m_percentileOffset[frame] != offset);
+				if (!reproject && !needPercentile)
+					continue;
+
+				if (aligned && !needPercentile)
+					project(frame, offset, nullptr, false);
+				else
+				{
+					OctVolume::Frame octImage = octVolume.at(frame);
+					project(frame, offset, &octImage, needPercentile);
+				}
+			}
+			else if (!isReady || isReady(frame))
+			{
+				// Not processed by this object yet (e.g. loaded from the result cache)
+				OctVolume::Frame octImage = octVolume.at(frame);
+				if (octImage.length() != 0)
+					processFrame(octImage, frame);
+			}
+		}
+	});
+}
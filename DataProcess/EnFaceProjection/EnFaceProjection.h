@@ -0,0 +1,82 @@
+#ifndef ENFACEPROJECTION_H
+#define ENFACEPROJECTION_H
+
+#include <QString>
+
+#include <iostream>
+#include <vector>
+#include <atomic>
+#include <mutex>
+#include <functional>
+
+#include <Havana2/Configuration.h>
+
+#include <Common/array.h>
+
+#include <MemoryBuffer/OctVolume.h>
+
+// En face projections of the result volume (maximum, mean, minimum, standard deviation, percentile)
+// The depth window is [circShift + PROJECTION_OFFSET, CIRC_RADIUS), changed with the block statistics of the frames.
+
+class EnFaceProjection
+{
+public:
+	enum statistic { maximum = 0, mean, minimum, stdev, percentile };
+	static const int nStatistics = 5;
+
+public:
+	EnFaceProjection();
+	virtual ~EnFaceProjection();
+
+private: // Not to call copy constrcutor and copy assignment operator
+	EnFaceProjection(const EnFaceProjection&);
+	EnFaceProjection& operator=(const EnFaceProjection&);
+
+public:
+	void allocate(int nAlines, int nFrames, int offset);
+	void clear();
+
+	// Statistics of a processed frame (thread-safe for different frames)
+	void processFrame(const OctVolume::Frame& octImage, int frame);
+
+	// Frames are read only if necessary. The frames not processed yet are processed if isReady(frame) is true
+	// (e.g. the projection loaded from the result cache without the blocks).
+	void setOffset(int offset, OctVolume& octVolume, const std::function<bool(int)>& isReady);
+	void setStatistic(statistic stat, OctVolume& octVolume, const std::function<bool(int)>& isReady);
+
+	inline np::FloatArray2& projection() { return m_proj[m_stat]; }
+	inline np::FloatArray2& projection(statistic stat) { return m_proj[stat]; }
+	inline statistic currentStatistic() const { return m_stat; }
+	inline int offset() const { return m_offset; }
+	inline size_t memoryUsage() const { return sizeof(Block) * m_blocks.size() + sizeof(float) * nStatistics * (size_t)m_nAlines * m_nFrames; }
+
+	static QString name(statistic stat); // for the file names
+
+private:
+	struct Block
+	{
+		OctVolume::value_type max, min;
+		float sum, m2; // sum & sum of squared deviations from the mean (dB)
+	};
+
+	static void getBlock(const OctVolume::value_type* src, int len, Block& block);
+	inline Block* blocks(int frame, int aline) { return &m_blocks[((size_t)frame * m_nAlines + aline) * m_nBlocks]; }
+
+	void project(int frame, int offset, const OctVolume::Frame* pImage, bool withPercentile);
+	void update(OctVolume& octVolume, const std::function<bool(int)>& isReady, bool reproject);
+
+private:
+	int m_nAlines, m_nFrames;
+	int m_nBlocks, m_blockStart; // blocks of [m_blockStart, CIRC_RADIUS)
+
+	std::vector<Block> m_blocks; // frame x A-line x block
+	std::vector<std::atomic<bool>> m_processed; // blocks are valid & projected with m_offset (at that time)
+	std::vector<int> m_percentileOffset; // offset of the percentile (-1 if not computed)
+
+	np::FloatArray2 m_proj[nStatistics];
+	std::atomic<int> m_offset;
+	std::mutex m_mtxOffset;
+	statistic m_stat;
+};
+
+#endif // ENFACEPROJECTION_H
@@ -60,54 +60,83 @@ OCTProcess::~OCTProcess()
 {
 }
 
-#include <Havana2/Viewer/QScope.h>
-
 /* OCT Image */
-void OCTProcess::operator() (float* img, uint16_t* fringe)
+void OCTProcess::operator() (float* img, const uint16_t* fringe)
+{	
+	tbb::parallel_for(tbb::blocked_range<size_t>(0, (size_t)raw_size.height),
+		[&](const tbb::blocked_range<size_t>& r) {
+		for (size_t i = r.begin(); i != r.end(); ++i)
+		{
+			int f2 = fft2_size.width * (int)i;
+
+			// 1-8. Power spectrum
+			Ipp32f* power = powerSpectrum((int)i, fringe);
+
+			// 9. dB Scaling
+			ippsLog10_32f_A11(power, img + f2, fft2_size.width);
+			ippsMulC_32f_I(10.0f, img + f2, fft2_size.width);
+		}
+	});
+}
+
+void OCTProcess::operator() (int16_t* img, const uint16_t* fringe)
 {	
 	tbb::parallel_for(tbb::blocked_range<size_t>(0, (size_t)raw_size.height),
 		[&](const tbb::blocked_range<size_t>& r) {
 		for (size_t i = r.begin(); i != r.end(); ++i)
 		{
-			int r1 = raw_size.width * (int)i;
-			int f1 = fft_size.width * (int)i;
 			int f2 = fft2_size.width * (int)i;
 
-			// 1. Single Precision Conversion & Zero Padding
-			ippsConvert_16u32f(fringe + r1, signal.raw_ptr() + f1, raw_size.width);
+			// 1-8. Power spectrum
+			Ipp32f* power = powerSpectrum((int)i, fringe);
+
+			// 9. Fixed-point dB Scaling (in place, 1 / 2^OCT_DB_FRAC_BITS dB)
+			ippsLog10_32f_A11(power, power, fft2_size.width);
+			ippsMulC_32f_I(10.0f * (float)(1 << OCT_DB_FRAC_BITS), power, fft2_size.width);
+			ippsConvert_32f16s_Sfs(power, img + f2, fft2_size.width, ippRndNear, 0);
+		}
+	});
+}
+
+Ipp32f* OCTProcess::powerSpectrum(int i, const uint16_t* fringe)
+{
+	int r1 = raw_size.width * i;
+	int f1 = fft_size.width * i;
+	int f2 = fft2_size.width * i;
+
+	// 1. Single Precision Conversion & Zero Padding
+	ippsConvert_16u32f(fringe + r1, signal.raw_ptr() + f1, raw_size.width);
 	
-			// 2. BG Subtraction & Hanning Windowing
-			ippsSub_32f_I(bg, signal.raw_ptr() + f1, raw_size.width);
-			ippsMul_32f_I(win, signal.raw_ptr() + f1, raw_size.width);
+	// 2. BG Subtraction & Hanning Windowing
+	ippsSub_32f_I(bg, signal.raw_ptr() + f1, raw_size.width);
+	ippsMul_32f_I(win, signal.raw_ptr() + f1, raw_size.width);
 
-			// 3. DC Background Removal
-			mov_avg(add_bg.raw_ptr() + f1, signal.raw_ptr() + f1);
-			std::rotate(add_bg.raw_ptr() + f1, add_bg.raw_ptr() + f1 + WIDTH_FILTER / 2, add_bg.raw_ptr() + f1 + raw_size.width);
-			ippsSub_32f_I(add_bg.raw_ptr() + f1, signal.raw_ptr() + f1, raw_size.width);
+	// 3. DC Background Removal
+	mov_avg(add_bg.raw_ptr() + f1, signal.raw_ptr() + f1);
+	std::rotate(add_bg.raw_ptr() + f1, add_bg.raw_ptr() + f1 + WIDTH_FILTER / 2, add_bg.raw_ptr() + f1 + raw_size.width);
+	ippsSub_32f_I(add_bg.raw_ptr() + f1, signal.raw_ptr() + f1, raw_size.width);
 
-			// 4. Fourier transform
-			fft1((Ipp32fc*)(fft_complex1.raw_ptr() + f1), signal.raw_ptr() + f1, (int)i);
+	// 4. Fourier transform
+	fft1((Ipp32fc*)(fft_complex1.raw_ptr() + f1), signal.raw_ptr() + f1, i);
 
-			// 5. Mirror Image Removal
-			ippsSet_32f(0.0f, (Ipp32f*)(fft_complex1.raw_ptr() + f1 + fft_size.width / 2), fft_size.width);
-			fft2.inverse((Ipp32fc*)(complex_signal.raw_ptr() + f1), (const Ipp32fc*)(fft_complex1.raw_ptr() + f1));
+	// 5. Mirror Image Removal
+	ippsSet_32f(0.0f, (Ipp32f*)(fft_complex1.raw_ptr() + f1 + fft_size.width / 2), fft_size.width);
+	fft2.inverse((Ipp32fc*)(complex_signal.raw_ptr() + f1), (const Ipp32fc*)(fft_complex1.raw_ptr() + f1));
 						
-			// 6. k linear resampling	
-            bf::LinearInterp_32fc((const Ipp32fc*)(complex_signal.raw_ptr() + f1), (Ipp32fc*)(complex_resamp.raw_ptr() + f1),
-				raw_size.width, calib_index.raw_ptr(), calib_weight.raw_ptr());
+	// 6. k linear resampling	
+	bf::LinearInterp_32fc((const Ipp32fc*)(complex_signal.raw_ptr() + f1), (Ipp32fc*)(complex_resamp.raw_ptr() + f1),
+		raw_size.width, calib_index.raw_ptr(), calib_weight.raw_ptr());
 			
-			// 7. Dispersion compensation
-			ippsMul_32fc_I((const Ipp32fc*)dispersion1.raw_ptr(), (Ipp32fc*)(complex_resamp.raw_ptr() + f1), raw_size.width);
+	// 7. Dispersion compensation
+	ippsMul_32fc_I((const Ipp32fc*)dispersion1.raw_ptr(), (Ipp32fc*)(complex_resamp.raw_ptr() + f1), raw_size.width);
 			
-			// 8. Fourier transform
-			fft3.forward((Ipp32fc*)(fft_complex2.raw_ptr() + f1), (const Ipp32fc*)(complex_resamp.raw_ptr() + f1));
+	// 8. Fourier transform
+	fft3.forward((Ipp32fc*)(fft_complex2.raw_ptr() + f1), (const Ipp32fc*)(complex_resamp.raw_ptr() + f1));
 
-			// 9. dB Scaling
-			ippsPowerSpectr_32fc((const Ipp32fc*)(fft_complex1.raw_ptr() + f1), fft_linear.raw_ptr() + f2, fft2_size.width);
-			ippsLog10_32f_A11(fft_linear.raw_ptr() + f2, img + f2, fft2_size.width);
-			ippsMulC_32f_I(10.0f, img + f2, fft2_size.width);
-		}
-	});
+	// Power spectrum
+	ippsPowerSpectr_32fc((const Ipp32fc*)(fft_complex1.raw_ptr() + f1), fft_linear.raw_ptr() + f2, fft2_size.width);
+
+	return fft_linear.raw_ptr() + f2;
 }
 
 
@@ -248,6 +277,17 @@ void OCTProcess::generateCalibration(int discom_val)
 }
 
 
+void OCTProcess::copyCalibration(const OCTProcess& src)
+{
+	memcpy(bg.raw_ptr(), src.bg.raw_ptr(), sizeof(float) * bg.length());
+	memcpy(calib_index.raw_ptr(), src.calib_index.raw_ptr(), sizeof(float) * calib_index.length());
+	memcpy(calib_weight.raw_ptr(), src.calib_weight.raw_ptr(), sizeof(float) * calib_weight.length());
+	memcpy(dispersion.raw_ptr(), src.dispersion.raw_ptr(), sizeof(std::complex<float>) * dispersion.length());
+	memcpy(discom.raw_ptr(), src.discom.raw_ptr(), sizeof(std::complex<float>) * discom.length());
+	memcpy(dispersion1.raw_ptr(), src.dispersion1.raw_ptr(), sizeof(std::complex<float>) * dispersion1.length());
+}
+
+
 void OCTProcess::changeDiscomValue(int discom_val)
 {
 	double temp;
@@ -298,20 +338,38 @@ void OCTProcess::saveCalibration(QString calibpath)
 
 
 void OCTProcess::loadCalibration(QString calibpath, QString bgpath)
+{
+	QFile calibFile(calibpath), bgFile(bgpath);
+	calibFile.open(QIODevice::ReadOnly);
+	bgFile.open(QIODevice::ReadOnly);
+
+	loadCalibration(&calibFile, &bgFile);
+}
+
+void OCTProcess::loadCalibrationData(const QByteArray& calib, const QByteArray& background)
+{
+	QBuffer calibBuffer, bgBuffer;
+	calibBuffer.setData(calib);
+	bgBuffer.setData(background);
+	if (!calib.isEmpty()) calibBuffer.open(QIODevice::ReadOnly);
+	if (!background.isEmpty()) bgBuffer.open(QIODevice::ReadOnly);
+
+	loadCalibration(&calibBuffer, &bgBuffer);
+}
+
+void OCTProcess::loadCalibration(QIODevice* pCalib, QIODevice* pBg)
 {
 	qint64 sizeRead, sizeTotalRead = 0;
 
 	printf("\n//// Load OCT Calibration Data ////\n");
 
-	// create file (background)
-	QFile bgFile(bgpath);
-
+	// background
 	Uint16Array2 frame(raw_size.width, raw_size.height);	
 
-	if (false != bgFile.open(QIODevice::ReadOnly))
+	if (pBg->isOpen())
 	{
 		// background
-		sizeRead = bgFile.read(reinterpret_cast<char*>(frame.raw_ptr()), sizeof(uint16_t) * frame.length());
+		sizeRead = pBg->read(reinterpret_cast<char*>(frame.raw_ptr()), sizeof(uint16_t) * frame.length());
 		printf("Background data is successfully loaded.[%zu]\n", sizeRead);
 
 		if (sizeRead)
@@ -334,34 +392,33 @@ void OCTProcess::loadCalibration(QString calibpath, QString bgpath)
 			}
 		}
 
-		bgFile.close();
+		pBg->close();
 	}
 	else
 		printf("Background data cannot be loaded.\n");
 
-	// create file (calibration)
-	QFile calibFile(calibpath);
-	if (false != calibFile.open(QFile::ReadOnly))
+	// calibration
+	if (pCalib->isOpen())
 	{
 		// calib_index
-		sizeRead = calibFile.read(reinterpret_cast<char*>(calib_index.raw_ptr()), sizeof(float) * raw_size.width);
+		sizeRead = pCalib->read(reinterpret_cast<char*>(calib_index.raw_ptr()), sizeof(float) * raw_size.width);
 		sizeTotalRead += sizeRead;
 		printf("Calibration index is successfully loaded.[%zu]\n", sizeRead);
 
 		// calib_weight
-		sizeRead = calibFile.read(reinterpret_cast<char*>(calib_weight.raw_ptr()), sizeof(float) * raw_size.width);
+		sizeRead = pCalib->read(reinterpret_cast<char*>(calib_weight.raw_ptr()), sizeof(float) * raw_size.width);
 		sizeTotalRead += sizeRead;
 		printf("Calibration weight is successfully loaded.[%zu]\n", sizeRead);
 
 		// dispersion compensation real
 		Ipp32f* real = ippsMalloc_32f(raw_size.width);
-		sizeRead = calibFile.read(reinterpret_cast<char*>(real), sizeof(float) * raw_size.width);
+		sizeRead = pCalib->read(reinterpret_cast<char*>(real), sizeof(float) * raw_size.width);
 		sizeTotalRead += sizeRead;
 		printf("Dispersion data (real) is successfully loaded.[%zu]\n", sizeRead);
 
 		// dispersion compensation imag
 		Ipp32f* imag = ippsMalloc_32f(raw_size.width);
-		sizeRead = calibFile.read(reinterpret_cast<char*>(imag), sizeof(float) * raw_size.width);
+		sizeRead = pCalib->read(reinterpret_cast<char*>(imag), sizeof(float) * raw_size.width);
 		sizeTotalRead += sizeRead;
 		printf("Dispersion data (imag) is successfully loaded.[%zu]\n", sizeRead);
 
@@ -370,7 +427,7 @@ void OCTProcess::loadCalibration(QString calibpath, QString bgpath)
 		ippsFree(real); ippsFree(imag);
 		changeDiscomValue(0);
 
-		calibFile.close();
+		pCalib->close();
 	}
 	else
 		printf("Calibration data cannot be loaded.\n");
@@ -6,9 +6,11 @@
 #include <iostream>
 #include <thread>
 #include <complex>
+#include <algorithm>
 
 #include <QString>
 #include <QFile>
+#include <QBuffer>
 
 #include <ipps.h>
 #include <ippvm.h>
@@ -170,7 +172,8 @@ private: // Not to call copy constrcutor and copy assignment operator
 	
 public:
 	// Generate OCT image
-	void operator()(float* img, uint16_t* fringe);
+	void operator()(float* img, const uint16_t* fringe);
+	void operator()(int16_t* img, const uint16_t* fringe); // fixed-point dB (OCT_DB_FRAC_BITS)
 	   
 	// For calibration
     void setBg(const Uint16Array2& frame);
@@ -183,11 +186,17 @@ public:
     void changeDiscomValue(int discom_val = 0);
 	void saveCalibration(QString calibpath = "calibration.dat");
 	void loadCalibration(QString calibpath = "calibration.dat", QString bgpath = "bg.bin");
+	void loadCalibrationData(const QByteArray& calib, const QByteArray& background); // embedded in the data container
+	void copyCalibration(const OCTProcess& src); // for processing workers of the same size
 
 	// For calibration dialog
 	callback2<float*, const char*> drawGraph;
 	callback2<int&, int&> waitForRange;
 	callback<void> endCalibration;
+
+private:
+	Ipp32f* powerSpectrum(int i, const uint16_t* fringe); // power spectrum of i-th A-line (steps 1-8)
+	void loadCalibration(QIODevice* pCalib, QIODevice* pBg);
     
 // Variables
 private:
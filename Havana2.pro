@@ -83,12 +83,18 @@ SOURCES += Havana2/Havana2.cpp \
     Havana2/Dialog/SaveResultDlg.cpp
 
 SOURCES += DataProcess/OCTProcess/OCTProcess.cpp \
+    DataProcess/EnFaceProjection/EnFaceProjection.cpp \
     DataProcess/ThreadManager.cpp
 
 SOURCES += DataAcquisition/NI_FrameGrabber/NI_FrameGrabber.cpp \
     DataAcquisition/DataAcquisition.cpp
 
-SOURCES += MemoryBuffer/MemoryBuffer.cpp
+SOURCES += MemoryBuffer/MemoryBuffer.cpp \
+    MemoryBuffer/OctDataFile.cpp \
+    MemoryBuffer/MappedRawFile.cpp \
+    MemoryBuffer/OctVolume.cpp \
+    MemoryBuffer/OctResultCache.cpp \
+    MemoryBuffer/RenderCache.cpp
 
 SOURCES += DeviceControl/GalvoScan/GalvoScan.cpp \
     DeviceControl/ZaberStage/ZaberStage.cpp \
@@ -111,12 +117,18 @@ HEADERS += Havana2/Configuration.h \
     Havana2/Dialog/SaveResultDlg.h
 
 HEADERS += DataProcess/OCTProcess/OCTProcess.h \
+    DataProcess/EnFaceProjection/EnFaceProjection.h \
     DataProcess/ThreadManager.h
 
 HEADERS += DataAcquisition/NI_FrameGrabber/NI_FrameGrabber.h \
     DataAcquisition/DataAcquisition.h
 
-HEADERS += MemoryBuffer/MemoryBuffer.h
+HEADERS += MemoryBuffer/MemoryBuffer.h \
+    MemoryBuffer/OctDataFile.h \
+    MemoryBuffer/MappedRawFile.h \
+    MemoryBuffer/OctVolume.h \
+    MemoryBuffer/OctResultCache.h \
+    MemoryBuffer/RenderCache.h
 
 HEADERS += DeviceControl/GalvoScan/GalvoScan.h \
     DeviceControl/ZaberStage/ZaberStage.h \
@@ -42,11 +42,25 @@
 #define PROCESSING_BUFFER_SIZE		50
 #define WIDTH_FILTER				51
 
+#define OFFLINE_PROCESSING_WORKERS	4 // Frames processed concurrently (an OCTProcess object per worker)
+#define LAZY_PREFETCH_FRAMES		4 // Neighbors of the selected frame processed first (on-demand processing)
+
+#define MAPPED_WINDOW_FRAMES		64 // Sliding window of memory-mapped raw data
+#define MAPPED_PREFETCH_FRAMES		8
+
 #ifdef _DEBUG
 #define WRITING_BUFFER_SIZE			50
 #else
 #define WRITING_BUFFER_SIZE	        1000
 #endif
+#define WRITING_CHUNK_FRAMES		16 // Frames per write call
+#define PROGRESS_UPDATE_INTERVAL	100 // msec
+
+#define VOLUME_MEMORY_BUDGET		2048 // MB, processed images beyond it are spilled to a scratch file
+#define OCT_DB_FIXED_POINT			// Processed images are stored in 16-bit fixed-point dB (comment out for float)
+#define OCT_DB_FRAC_BITS			7 // 1/128 dB resolution, -256 ~ 256 dB range
+#define OCT_RESULT_CACHE			// Processed results are cached next to the raw data (*.hvr) (comment out to disable)
+#define OCT_PROCESSING_VERSION		1 // Increase when the processing chain changes (invalidates the cached results)
 
 //////////////////////// OCT system /////////////////////////
 #define DISCOM_VAL					0 
@@ -54,8 +68,19 @@
 /////////////////////// Visualization ///////////////////////
 #define CIRC_RADIUS					800 // It should be a multiple of 4.
 #define PROJECTION_OFFSET			100
+#define PROJECTION_BLOCK			64 // Depth block of the en face statistics (the window is changed without a full pass)
+#define PROJECTION_PERCENTILE		90
+#define PROJECTION_STDEV_RANGE		20 // dB, standard deviation map is displayed in [0, PROJECTION_STDEV_RANGE]
 
 #define RENEWAL_COUNT				1
+//#define PIPELINE_LOG				// Latency & dropped frame report in the console (uncomment to enable)
+#define PIPELINE_LOG_COUNT			500 // Frames per latency & dropped frame report
+#define LIVE_MAP_FRAMES				500 // Frames in the live en face & L-mode maps (sweep display)
+#define DISPLAY_RATE				60 // Hz, target rate of the live display (only the newest processed frame is shown)
+
+#define RENDER_CACHE_FRAMES			32 // Display-ready frames cached for each view (result tab)
+#define RENDER_PREFETCH_FRAMES		4 // Neighbors of the displayed frame rendered ahead
+#define RENDER_WORKERS				2
 
 
 
@@ -48,12 +48,12 @@ SaveResultDlg::SaveResultDlg(QWidget *parent) :
 
 	m_pLineEdit_RectWidth = new QLineEdit(this);
 	m_pLineEdit_RectWidth->setFixedWidth(35);
-	m_pLineEdit_RectWidth->setText(QString::number(m_pResultTab->m_vectorOctImage.at(0).size(0)));
+	m_pLineEdit_RectWidth->setText(QString::number(m_pResultTab->m_octVolume.width()));
 	m_pLineEdit_RectWidth->setAlignment(Qt::AlignCenter);
 	m_pLineEdit_RectWidth->setDisabled(true);
 	m_pLineEdit_RectHeight = new QLineEdit(this);
 	m_pLineEdit_RectHeight->setFixedWidth(35);
-	m_pLineEdit_RectHeight->setText(QString::number(m_pResultTab->m_vectorOctImage.at(0).size(1)));
+	m_pLineEdit_RectHeight->setText(QString::number(m_pResultTab->m_octVolume.height()));
 	m_pLineEdit_RectHeight->setAlignment(Qt::AlignCenter);
 	m_pLineEdit_RectHeight->setDisabled(true);
 	m_pLineEdit_CircDiameter = new QLineEdit(this);
@@ -162,7 +162,7 @@ void SaveResultDlg::saveCrossSections()
 		m_nSavedFrames = 0;
 
 		// Scaling Images ///////////////////////////////////////////////////////////////////////////
-		std::thread scaleImages([&]() { scaling(m_pResultTab->m_vectorOctImage); });
+		std::thread scaleImages([&]() { scaling(m_pResultTab->m_octVolume); });
 
 		// Rect Writing /////////////////////////////////////////////////////////////////////////////
 		std::thread writeRectImages([&]() { rectWriting(checkList); });
@@ -209,7 +209,7 @@ void SaveResultDlg::saveEnFaceMaps()
 		{
 			if (checkList.bOctProj)
 			{
-				QFile fileOctMaxProj(enFacePath + "oct_max_projection.enface");
+				QFile fileOctMaxProj(enFacePath + "oct_" + m_pResultTab->getOctProjectionName() + "_projection.enface");
 				if (false != fileOctMaxProj.open(QIODevice::WriteOnly))
 				{
 					fileOctMaxProj.write(reinterpret_cast<char*>(m_pResultTab->m_octProjection.raw_ptr()), sizeof(float) * m_pResultTab->m_octProjection.length());
@@ -221,14 +221,14 @@ void SaveResultDlg::saveEnFaceMaps()
 		// Scaled en face map writing ///////////////////////////////////////////////////////////////
 		if (checkList.bScaled)
 		{
-			ColorTable temp_ctable;
+			const ColorTable& temp_ctable = ColorTable::instance();
 
 			if (checkList.bOctProj)
 			{
 				IppiSize roi_proj = { m_pResultTab->m_octProjection.size(0), m_pResultTab->m_octProjection.size(1) };
 				ImageObject imgObjOctMaxProj(roi_proj.width, roi_proj.height, temp_ctable.m_colorTableVector.at(m_pResultTab->getCurrentOctColorTable()));
 
-				ippiScale_32f8u_C1R(m_pResultTab->m_octProjection, sizeof(float) * roi_proj.width, imgObjOctMaxProj.arr.raw_ptr(), sizeof(uint8_t) * roi_proj.width, roi_proj, m_pConfig->octDbRange.min, m_pConfig->octDbRange.max);
+				ippiScale_32f8u_C1R(m_pResultTab->m_octProjection, sizeof(float) * roi_proj.width, imgObjOctMaxProj.arr.raw_ptr(), sizeof(uint8_t) * roi_proj.width, roi_proj, m_pResultTab->getOctProjectionRange().min, m_pResultTab->getOctProjectionRange().max);
 				ippiMirror_8u_C1IR(imgObjOctMaxProj.arr.raw_ptr(), sizeof(uint8_t) * roi_proj.width, roi_proj, ippAxsHorizontal);
 #ifdef GALVANO_MIRROR
 				if (m_pConfig->galvoHorizontalShift)
@@ -240,7 +240,7 @@ void SaveResultDlg::saveEnFaceMaps()
 					}
 				}
 #endif
-				imgObjOctMaxProj.qindeximg.save(enFacePath + "oct_max_projection.bmp", "bmp");
+				imgObjOctMaxProj.qindeximg.save(enFacePath + "oct_" + m_pResultTab->getOctProjectionName() + "_projection.bmp", "bmp");
 			}
 		}
 
@@ -300,38 +300,31 @@ void SaveResultDlg::setWidgetsEnabled(bool enabled)
 }
 
 
-void SaveResultDlg::scaling(std::vector<np::FloatArray2>& vectorOctImage)
+void SaveResultDlg::scaling(OctVolume& octVolume)
 {
-	int nTotalFrame = (int)vectorOctImage.size();
-	ColorTable temp_ctable;
+	int nTotalFrame = octVolume.size();
+	const ColorTable& temp_ctable = ColorTable::instance();
 	
+	IppiSize roi_oct = { octVolume.width(), octVolume.height() };
+	display_kernel rectKernel(roi_oct.width, roi_oct.height);
+
 	int frameCount = 0;
 	while (frameCount < nTotalFrame)
 	{
 		// Create Image Object Array for threading operation
-		IppiSize roi_oct = { vectorOctImage.at(0).size(0), vectorOctImage.at(0).size(1) };
 
 		ImgObjVector* pImgObjVec = new ImgObjVector;
 
 		// Image objects for OCT Images
 		pImgObjVec->push_back(new ImageObject(roi_oct.height, roi_oct.width, temp_ctable.m_colorTableVector.at(m_pResultTab->getCurrentOctColorTable())));
 
-		// OCT Visualization
-		np::Uint8Array2 scale_temp(roi_oct.width, roi_oct.height);
-		ippiScale_32f8u_C1R(vectorOctImage.at(frameCount), roi_oct.width * sizeof(float),
-			scale_temp.raw_ptr(), roi_oct.width * sizeof(uint8_t), roi_oct, m_pConfig->octDbRange.min, m_pConfig->octDbRange.max);
-		ippiTranspose_8u_C1R(scale_temp.raw_ptr(), roi_oct.width * sizeof(uint8_t), pImgObjVec->at(0)->arr.raw_ptr(), roi_oct.height * sizeof(uint8_t), roi_oct);
+		// OCT Visualization (scaling, transpose, galvo shift & median filtering in a pass)
+		np::FloatArray2 octImage = octVolume.atFloat(frameCount);
+		int galvoShift = 0;
 #ifdef GALVANO_MIRROR
-		if (m_pConfig->galvoHorizontalShift)
-		{
-			for (int i = 0; i < roi_oct.width; i++)
-			{
-				uint8_t* pImg = pImgObjVec->at(0)->arr.raw_ptr() + i * roi_oct.height;
-				std::rotate(pImg, pImg + m_pConfig->galvoHorizontalShift, pImg + roi_oct.height);
-			}
-		}
+		galvoShift = m_pConfig->galvoHorizontalShift;
 #endif
-		(*m_pResultTab->m_pMedfiltRect)(pImgObjVec->at(0)->arr.raw_ptr());
+		rectKernel(octImage.raw_ptr(), pImgObjVec->at(0)->arr.raw_ptr(), (float)m_pConfig->octDbRange.min, (float)m_pConfig->octDbRange.max, 0, galvoShift);
 
 		frameCount++;
 
@@ -342,7 +335,7 @@ void SaveResultDlg::scaling(std::vector<np::FloatArray2>& vectorOctImage)
 
 void SaveResultDlg::rectWriting(CrossSectionCheckList checkList)
 {
-	int nTotalFrame = (int)m_pResultTab->m_vectorOctImage.size();
+	int nTotalFrame = m_pResultTab->m_octVolume.size();
 	QString folderName;
 	for (int i = 0; i < m_pResultTab->m_path.length(); i++)
 		if (m_pResultTab->m_path.at(i) == QChar('/')) folderName = m_pResultTab->m_path.right(m_pResultTab->m_path.length() - i - 1);
@@ -377,8 +370,8 @@ void SaveResultDlg::rectWriting(CrossSectionCheckList checkList)
 
 void SaveResultDlg::circularizing(CrossSectionCheckList checkList)
 {
-	int nTotalFrame = (int)m_pResultTab->m_vectorOctImage.size();
-	ColorTable temp_ctable;
+	int nTotalFrame = m_pResultTab->m_octVolume.size();
+	const ColorTable& temp_ctable = ColorTable::instance();
 
 	int frameCount = 0;
 	while (frameCount < nTotalFrame)
@@ -413,7 +406,7 @@ void SaveResultDlg::circularizing(CrossSectionCheckList checkList)
 
 void SaveResultDlg::circWriting(CrossSectionCheckList checkList)
 {
-	int nTotalFrame = (int)m_pResultTab->m_vectorOctImage.size();
+	int nTotalFrame = m_pResultTab->m_octVolume.size();
 	QString folderName;
 	for (int i = 0; i < m_pResultTab->m_path.length(); i++)
 		if (m_pResultTab->m_path.at(i) == QChar('/')) folderName = m_pResultTab->m_path.right(m_pResultTab->m_path.length() - i - 1);
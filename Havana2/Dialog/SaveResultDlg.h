@@ -12,11 +12,13 @@
 
 #include <Common/array.h>
 #include <Common/circularize.h>
-#include <Common/medfilt.h>
+#include <Common/display_kernel.h>
 #include <Common/Queue.h>
 #include <Common/ImageObject.h>
 #include <Common/basic_functions.h>
 
+#include <MemoryBuffer/OctVolume.h>
+
 class MainWindow;
 class QResultTab;
 
@@ -64,7 +66,7 @@ signals:
 	void savedSingleFrame(int);
 
 private:
-	void scaling(std::vector<np::FloatArray2>& vectorOctImage);
+	void scaling(OctVolume& octVolume);
 	void converting(CrossSectionCheckList checkList);
 	void rectWriting(CrossSectionCheckList checkList);
 	void circularizing(CrossSectionCheckList checkList);
@@ -161,7 +161,10 @@ void QOperationTab::operateDataRecording(bool toggled)
 		{
 			m_pToggleButton_Recording->setText("Stop &Recording");
 			m_pToggleButton_Acquisition->setDisabled(true);
-			m_pToggleButton_Saving->setDisabled(true);
+			m_pToggleButton_Saving->setEnabled(true); // Saving is available while recording
+
+			m_pProgressBar->setRange(0, WRITING_BUFFER_SIZE - 1);
+			m_pProgressBar->setValue(0);
 		}
 		else
 		{
@@ -177,14 +180,23 @@ void QOperationTab::operateDataRecording(bool toggled)
 
 		m_pToggleButton_Recording->setText("Start &Recording");
 		m_pToggleButton_Acquisition->setEnabled(true);
-		m_pToggleButton_Saving->setEnabled(m_pMemoryBuffer->m_nRecordedFrames != 0);
 		m_pMainWnd->m_pResultTab->getRadioInBuffer()->setEnabled(m_pMemoryBuffer->m_nRecordedFrames != 0);
 
 		if (m_pMemoryBuffer->m_nRecordedFrames > 1)
 			m_pProgressBar->setRange(0, m_pMemoryBuffer->m_nRecordedFrames - 1);
 		else
 			m_pProgressBar->setRange(0, 1);
-		m_pProgressBar->setValue(0);
+
+		if (m_pMemoryBuffer->m_bIsSaving)
+		{
+			// Saving thread keeps writing the remaining frames
+			m_pToggleButton_Recording->setDisabled(true);
+		}
+		else
+		{
+			m_pToggleButton_Saving->setEnabled(m_pMemoryBuffer->m_nRecordedFrames != 0);
+			m_pProgressBar->setValue(0);
+		}
 	}
 }
 
@@ -195,7 +207,8 @@ void QOperationTab::operateDataSaving(bool toggled)
 		if (m_pMemoryBuffer->startSaving())
 		{
 			m_pToggleButton_Saving->setText("Saving...");
-			m_pToggleButton_Recording->setDisabled(true);
+			if (!m_pToggleButton_Recording->isChecked())
+				m_pToggleButton_Recording->setDisabled(true);
 			m_pToggleButton_Saving->setDisabled(true);
 			m_pProgressBar->setFormat("Writing recorded data... %p%");
 		}
@@ -225,7 +238,7 @@ void QOperationTab::deleteDeviceSetupDlg()
 void QOperationTab::setAcqRecEnable()
 {
 	m_pToggleButton_Acquisition->setEnabled(true); 
-	m_pToggleButton_Recording->setEnabled(true);
+	m_pToggleButton_Recording->setEnabled(m_pMemoryBuffer->m_bIsAllocatedWritingBuffer); // not if the allocation failed
 }
 
 
@@ -11,6 +11,9 @@
 #include <Havana2/Dialog/SaveResultDlg.h>
 
 #include <MemoryBuffer/MemoryBuffer.h>
+#include <MemoryBuffer/OctDataFile.h>
+#include <MemoryBuffer/MappedRawFile.h>
+#include <MemoryBuffer/OctResultCache.h>
 
 #include <DataProcess/OCTProcess/OCTProcess.h>
 
@@ -24,6 +27,7 @@
 
 #include <iostream>
 #include <thread>
+#include <condition_variable>
 
 #include <time.h>
 
@@ -33,8 +37,8 @@
 
 QResultTab::QResultTab(QWidget *parent) :
     QDialog(parent), 
+	m_renderCache(m_octVolume), m_circDiameter(2 * CIRC_RADIUS),
 	m_pImgObjRectImage(nullptr), m_pImgObjCircImage(nullptr), m_pCirc(nullptr),
-	m_pMedfiltRect(nullptr), 
 	m_pSaveResultDlg(nullptr)
 {
 	// Set main window objects
@@ -45,6 +49,8 @@ QResultTab::QResultTab(QWidget *parent) :
 #endif
 	m_pMemBuff = m_pMainWnd->m_pOperationTab->m_pMemoryBuffer;
 
+	m_bLazyProcessing = false;
+
 
     // Create layout
 	QHBoxLayout* pHBoxLayout = new QHBoxLayout;
@@ -65,6 +71,7 @@ QResultTab::QResultTab(QWidget *parent) :
 	m_pImageView_CircImage->setMinimumHeight(600);
 	m_pImageView_CircImage->setDisabled(true);
 	m_pImageView_CircImage->setMovedMouseCallback([&](QPoint& p) { m_pMainWnd->m_pStatusLabel_ImagePos->setText(QString("(%1, %2)").arg(p.x(), 4).arg(p.y(), 4)); });
+	m_pImageView_CircImage->setResizedCallback([&](QSize size) { resizeCircImage(size); });
 	m_pImageView_CircImage->setSquare(true);
 	m_pImageView_CircImage->setSizePolicy(QSizePolicy::MinimumExpanding, QSizePolicy::MinimumExpanding);
 	m_pImageView_CircImage->setVisible(false);
@@ -75,7 +82,7 @@ QResultTab::QResultTab(QWidget *parent) :
 	pNullLabel->setSizePolicy(QSizePolicy::MinimumExpanding, QSizePolicy::MinimumExpanding);
 
 	// Create image view buffers
-	ColorTable temp_ctable;
+	const ColorTable& temp_ctable = ColorTable::instance();
 	m_pImgObjRectImage = new ImageObject(m_pConfig->nAlines4, m_pConfig->n2ScansFFT, temp_ctable.m_colorTableVector.at(m_pConfig->octColorTable));
 	m_pImgObjCircImage = new ImageObject(2 * CIRC_RADIUS, 2 * CIRC_RADIUS, temp_ctable.m_colorTableVector.at(m_pConfig->octColorTable));
 
@@ -112,14 +119,17 @@ QResultTab::QResultTab(QWidget *parent) :
 	connect(this, SIGNAL(setWidgets(bool, Configuration*)), this, SLOT(setWidgetsEnabled(bool, Configuration*)));
 	connect(this, SIGNAL(paintRectImage(uint8_t*)), m_pImageView_RectImage, SLOT(drawImage(uint8_t*)));
 	connect(this, SIGNAL(paintCircImage(uint8_t*)), m_pImageView_CircImage, SLOT(drawImage(uint8_t*)));
+	connect(this, SIGNAL(processedLazyFrame(int)), this, SLOT(visualizeProcessedFrame(int)));
+	connect(this, SIGNAL(finishedLazyProcessing()), this, SLOT(finishLazyProcessing()));
 }
 
 QResultTab::~QResultTab()
 {
+	m_renderCache.clear();
+
 	if (m_pImgObjRectImage) delete m_pImgObjRectImage;
 	if (m_pImgObjCircImage) delete m_pImgObjCircImage;
 
-	if (m_pMedfiltRect) delete m_pMedfiltRect;
 	if (m_pCirc) delete m_pCirc;	
 }
 
@@ -182,6 +192,9 @@ void QResultTab::createDataLoadingWritingTab()
 	m_pCheckBox_SingleFrame = new QCheckBox(this);
 	m_pCheckBox_SingleFrame->setText("Single Frame Processing");
 
+	m_pCheckBox_LazyProcessing = new QCheckBox(this);
+	m_pCheckBox_LazyProcessing->setText("On-Demand Processing (External Data)");
+
 	m_pLabel_DiscomValue = new QLabel("    Discom Value", this);
 
 	m_pLineEdit_DiscomValue = new QLineEdit(this);
@@ -220,8 +233,9 @@ void QResultTab::createDataLoadingWritingTab()
 
 	pGridLayout_DataLoadingWriting->addItem(pHBoxLayout_UserDefined, 2, 1, 1, 2);
 	pGridLayout_DataLoadingWriting->addItem(pHBoxLayout_SingleFrameDiscomValue, 3, 1, 1, 2);
+	pGridLayout_DataLoadingWriting->addWidget(m_pCheckBox_LazyProcessing, 4, 1, 1, 2);
 
-	pGridLayout_DataLoadingWriting->addWidget(m_pProgressBar_PostProcessing, 4, 1, 1, 2);
+	pGridLayout_DataLoadingWriting->addWidget(m_pProgressBar_PostProcessing, 5, 1, 1, 2);
 
 	pGridLayout_DataLoadingWriting->addItem(new QSpacerItem(0, 0, QSizePolicy::Expanding, QSizePolicy::Fixed), 0, 3, 3, 1);
 
@@ -371,10 +385,25 @@ void QResultTab::createEnFaceMapTab()
     m_pImageView_ColorbarOctProjection->setFixedWidth(30);
 
     m_pLabel_OctProjection = new QLabel(this);
-    m_pLabel_OctProjection->setText("OCT Maximum Projection Map");
+    m_pLabel_OctProjection->setText("OCT Projection Map");
+
+	m_pComboBox_EnFaceStatistic = new QComboBox(this);
+	m_pComboBox_EnFaceStatistic->addItem("Maximum");
+	m_pComboBox_EnFaceStatistic->addItem("Mean");
+	m_pComboBox_EnFaceStatistic->addItem("Minimum");
+	m_pComboBox_EnFaceStatistic->addItem("Std Dev");
+	m_pComboBox_EnFaceStatistic->addItem(QString("%1th Percentile").arg(PROJECTION_PERCENTILE));
+	m_pComboBox_EnFaceStatistic->setSizePolicy(QSizePolicy::Fixed, QSizePolicy::Fixed);
+	m_pComboBox_EnFaceStatistic->setDisabled(true);
 
     // Set layout
-    pGridLayout_EnFace->addWidget(m_pLabel_OctProjection, 0, 0, 1, 3);
+	QHBoxLayout *pHBoxLayout_OctProjection = new QHBoxLayout;
+	pHBoxLayout_OctProjection->setSpacing(3);
+	pHBoxLayout_OctProjection->addWidget(m_pLabel_OctProjection);
+	pHBoxLayout_OctProjection->addItem(new QSpacerItem(0, 0, QSizePolicy::Expanding, QSizePolicy::Fixed));
+	pHBoxLayout_OctProjection->addWidget(m_pComboBox_EnFaceStatistic);
+
+    pGridLayout_EnFace->addItem(pHBoxLayout_OctProjection, 0, 0, 1, 3);
     pGridLayout_EnFace->addWidget(m_pImageView_OctProjection, 1, 0);
     pGridLayout_EnFace->addWidget(m_pImageView_ColorbarOctProjection, 1, 1);
     QVBoxLayout *pVBoxLayout_Colorbar1 = new QVBoxLayout;
@@ -390,6 +419,7 @@ void QResultTab::createEnFaceMapTab()
 	connect(this, SIGNAL(paintOctProjection(uint8_t*)), m_pImageView_OctProjection, SLOT(drawImage(uint8_t*)));
 	connect(m_pLineEdit_OctDbMax, SIGNAL(textEdited(const QString &)), this, SLOT(adjustOctContrast()));
 	connect(m_pLineEdit_OctDbMin, SIGNAL(textEdited(const QString &)), this, SLOT(adjustOctContrast()));
+	connect(m_pComboBox_EnFaceStatistic, SIGNAL(currentIndexChanged(int)), this, SLOT(changeEnFaceStatistic(int)));
 }
 
 
@@ -433,53 +463,78 @@ void QResultTab::enableUserDefinedAlines(bool checked)
 
 void QResultTab::visualizeImage(int frame)
 {
-	if (m_vectorOctImage.size() != 0)
+	if (m_octVolume.size() != 0)
 	{
-		IppiSize roi_oct = { m_pImgObjRectImage->getHeight(), m_pImgObjRectImage->getWidth() };
+		// Frames not processed yet are requested first (drawn by visualizeProcessedFrame)
+		if (!m_frameScheduler.isDone(frame))
+			m_frameScheduler.request(frame);
+		else
+		{
+			// Display-ready image from the render cache (invalidated if the render parameters are changed)
+			RenderParams params = { m_quantDbRange.min, m_quantDbRange.max, m_pConfig->circShift, 0, m_circDiameter };
+#ifdef GALVANO_MIRROR
+			params.galvoShift = m_pConfig->galvoHorizontalShift;
+#endif
+			m_renderCache.setParams(params);
 
-		// OCT Visualization
-		np::Uint8Array2 scale_temp(roi_oct.width, roi_oct.height);
-		ippiScale_32f8u_C1R(m_vectorOctImage.at(frame), roi_oct.width * sizeof(float),
-			scale_temp.raw_ptr(), roi_oct.width * sizeof(uint8_t), roi_oct, m_pConfig->octDbRange.min, m_pConfig->octDbRange.max);
+			RenderCache::view v = m_pCheckBox_CircularizeImage->isChecked() ? RenderCache::circ : RenderCache::rect;
+			ImageObject* pImgObj = (v == RenderCache::rect) ? m_pImgObjRectImage : m_pImgObjCircImage;
 
-		for (int i = 0; i < roi_oct.height; i++)
-		{
-			uint8_t* pImg = scale_temp.raw_ptr() + i * roi_oct.width;
-			std::rotate(pImg, pImg + (roi_oct.width - m_pConfig->circShift), pImg + roi_oct.width);
-			memset(pImg, 0, sizeof(uint8_t) * m_pConfig->circShift);
-		}
+			np::Uint8Array2 img = m_renderCache.get(frame, v);
+			if (img.length() == pImgObj->arr.length()) // circ: display diameter
+				memcpy(pImgObj->arr.raw_ptr(), img.raw_ptr(), sizeof(uint8_t) * img.length());
 
-		ippiTranspose_8u_C1R(scale_temp.raw_ptr(), roi_oct.width * sizeof(uint8_t), m_pImgObjRectImage->arr.raw_ptr(), roi_oct.height * sizeof(uint8_t), roi_oct);
-#ifdef GALVANO_MIRROR
-		if (m_pConfig->galvoHorizontalShift)
-		{
-			for (int i = 0; i < roi_oct.width; i++)
+			if (v == RenderCache::rect)
 			{
-				uint8_t* pImg = m_pImgObjRectImage->arr.raw_ptr() + i * roi_oct.height;
-				std::rotate(pImg, pImg + m_pConfig->galvoHorizontalShift, pImg + roi_oct.height);
+				if (m_pImageView_RectImage->isEnabled()) emit paintRectImage(m_pImgObjRectImage->qindeximg.bits());
+			}
+			else
+			{
+				if (m_pImageView_CircImage->isEnabled()) emit paintCircImage(m_pImgObjCircImage->qindeximg.bits());
 			}
-		}
-#endif
-		(*m_pMedfiltRect)(m_pImgObjRectImage->arr.raw_ptr());
 
-		if (!m_pCheckBox_CircularizeImage->isChecked())
-		{
-			if (m_pImageView_RectImage->isEnabled()) emit paintRectImage(m_pImgObjRectImage->qindeximg.bits());
-		}
-		else
-		{
-			(*m_pCirc)(m_pImgObjRectImage->arr, m_pImgObjCircImage->arr.raw_ptr(), "vertical", 0);
-			if (m_pImageView_CircImage->isEnabled()) emit paintCircImage(m_pImgObjCircImage->qindeximg.bits());
+			// Neighbors are rendered ahead for browsing
+			m_renderCache.prefetch(frame, v);
 		}
 
 		m_pImageView_OctProjection->setHorizontalLine(1, m_visOctProjection.size(1) - frame);
 		m_pImageView_OctProjection->getRender()->update();
 
-		QString str; str.sprintf("Current Frame : %3d / %3d", frame + 1, (int)m_vectorOctImage.size());
+		QString str; str.sprintf("Current Frame : %3d / %3d", frame + 1, m_octVolume.size());
 		m_pLabel_SelectFrame->setText(str);
 	}
 }
 
+void QResultTab::resizeCircImage(const QSize& size)
+{
+	// Display resolution: multiple of 4 (no padding in the scan lines), no larger than the full resolution
+	// (saved images are still of the full resolution)
+	int diameter = std::max(std::min(std::min(size.width(), size.height()), 2 * CIRC_RADIUS) / 4 * 4, 4);
+	if (diameter == m_circDiameter)
+		return;
+
+	m_pImageView_CircImage->setDisplaySize(diameter, diameter);
+	m_circDiameter = diameter;
+
+	// The image object is of the display diameter (a valid image of its own size, not a part of a full size one)
+	QVector<QRgb> ctable = m_pImgObjCircImage->getColorTable();
+	delete m_pImgObjCircImage;
+	m_pImgObjCircImage = new ImageObject(diameter, diameter, ctable);
+
+	if (m_pCheckBox_CircularizeImage->isChecked() && m_pImageView_CircImage->isEnabled())
+		visualizeImage(m_pSlider_SelectFrame->value());
+}
+
+Range<int> QResultTab::getOctProjectionRange() const
+{
+	if (m_enFace.currentStatistic() != EnFaceProjection::stdev)
+		return m_pConfig->octDbRange;
+
+	Range<int> range;
+	range.max = PROJECTION_STDEV_RANGE;
+	return range;
+}
+
 void QResultTab::visualizeEnFaceMap(bool scaling)
 {
 	if (m_octProjection.size(0) != 0)
@@ -488,9 +543,10 @@ void QResultTab::visualizeEnFaceMap(bool scaling)
 		{
 			IppiSize roi_proj = { m_octProjection.size(0), m_octProjection.size(1) };
 
-			// Scaling OCT projection
+			// Scaling OCT projection (standard deviation: own range, not in the quantization range of dB values)
+			bool stdev = (m_enFace.currentStatistic() == EnFaceProjection::stdev);
 			ippiScale_32f8u_C1R(m_octProjection, sizeof(float) * roi_proj.width, m_visOctProjection, sizeof(uint8_t) * roi_proj.width,
-				roi_proj, m_pConfig->octDbRange.min, m_pConfig->octDbRange.max);
+				roi_proj, stdev ? 0.0f : m_quantDbRange.min, stdev ? PROJECTION_STDEV_RANGE : m_quantDbRange.max);
 			ippiMirror_8u_C1IR(m_visOctProjection, sizeof(uint8_t) * roi_proj.width, roi_proj, ippAxsHorizontal);
 #ifdef GALVANO_MIRROR
 			if (m_pConfig->galvoHorizontalShift)
@@ -507,6 +563,38 @@ void QResultTab::visualizeEnFaceMap(bool scaling)
 	}
 }
 
+void QResultTab::visualizeProcessedFrame(int frame)
+{
+	// Frame processed on demand
+	if (frame == m_pSlider_SelectFrame->value())
+		visualizeImage(frame);
+
+	// En face map is filled progressively
+	std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+	if (now - m_lastEnFaceUpdate > std::chrono::milliseconds(PROGRESS_UPDATE_INTERVAL))
+	{
+		visualizeEnFaceMap(true);
+		m_lastEnFaceUpdate = now;
+	}
+}
+
+void QResultTab::finishLazyProcessing()
+{
+	m_pPushButton_StartProcessing->setEnabled(true);
+	if (m_pRadioButton_External->isChecked() && (false == m_pCheckBox_SingleFrame->isChecked()))
+		m_pPushButton_SaveResults->setEnabled(true);
+
+	m_pProgressBar_PostProcessing->setFormat("");
+	m_pProgressBar_PostProcessing->setValue(0);
+
+	// Whole-volume projections are available after the background processing
+	m_pLabel_CircShift->setEnabled(true);
+	m_pLineEdit_CircShift->setEnabled(true);
+	m_pComboBox_EnFaceStatistic->setEnabled(true);
+
+	visualizeEnFaceMap(true);
+}
+
 void QResultTab::measureDistance(bool toggled)
 {
 	m_pImageView_CircImage->getRender()->m_bMeasureDistance = toggled;
@@ -555,9 +643,9 @@ void QResultTab::changeVisImage(bool toggled)
 void QResultTab::checkCircShift(const QString &str)
 {
 	int circShift = str.toInt();
-	if (circShift > CIRC_RADIUS - PROJECTION_OFFSET)
+	if ((circShift < 0) || (circShift > CIRC_RADIUS - PROJECTION_OFFSET))
 	{
-		circShift = CIRC_RADIUS - PROJECTION_OFFSET;
+		circShift = std::min(std::max(circShift, 0), CIRC_RADIUS - PROJECTION_OFFSET);
 		m_pLineEdit_CircShift->setText(QString("%1").arg(circShift));
 	}
 	m_pConfig->circShift = circShift;
@@ -568,11 +656,20 @@ void QResultTab::checkCircShift(const QString &str)
 		m_pImageView_CircImage->setCircle(2, m_pConfig->circShift, m_pConfig->circShift + PROJECTION_OFFSET);
 	}
 
-	getOctProjection(m_vectorOctImage, m_octProjection, circShift);
+	m_enFace.setOffset(circShift, m_octVolume, [&](int frame) { return m_frameScheduler.isDone(frame); });
 	visualizeEnFaceMap(true);
 	visualizeImage(m_pSlider_SelectFrame->value());
 }
 
+void QResultTab::changeEnFaceStatistic(int stat)
+{
+	m_enFace.setStatistic((EnFaceProjection::statistic)stat, m_octVolume, [&](int frame) { return m_frameScheduler.isDone(frame); });
+	m_octProjection = m_enFace.projection();
+
+	applyOctPalette();
+	visualizeEnFaceMap(true);
+}
+
 void QResultTab::adjustOctContrast()
 {
 	int min_dB = m_pLineEdit_OctDbMin->text().toInt();
@@ -584,20 +681,48 @@ void QResultTab::adjustOctContrast()
 	
 	m_pConfig->octColorTable = ctable_ind;
 
-	m_pImageView_RectImage->resetColormap(ColorTable::colortable(ctable_ind));
-	m_pImageView_CircImage->resetColormap(ColorTable::colortable(ctable_ind));
-	m_pImageView_OctProjection->resetColormap(ColorTable::colortable(ctable_ind));	
-	m_pImageView_ColorbarOctProjection->resetColormap(ColorTable::colortable(ctable_ind));
+	// Images are quantized again only if the dB range is out of the quantization range
+	bool requantized = updateQuantRange();
+	applyOctPalette();
 
-	ColorTable temp_ctable;
+	if (requantized)
+	{
+		visualizeEnFaceMap(true);
+		visualizeImage(m_pSlider_SelectFrame->value());
+	}
+}
 
-	if (m_pImgObjRectImage) delete m_pImgObjRectImage;
-	m_pImgObjRectImage = new ImageObject(m_pImageView_RectImage->getRender()->m_pImage->width(), m_pImageView_RectImage->getRender()->m_pImage->height(), temp_ctable.m_colorTableVector.at(ctable_ind));
-	if (m_pImgObjCircImage) delete m_pImgObjCircImage;
-	m_pImgObjCircImage = new ImageObject(m_pImageView_CircImage->getRender()->m_pImage->width(), m_pImageView_CircImage->getRender()->m_pImage->height(), temp_ctable.m_colorTableVector.at(ctable_ind));
+bool QResultTab::updateQuantRange()
+{
+	// Quantized images are valid while the dB range is in the quantization range with enough resolution (> 1/2)
+	int min_dB = std::min(m_pConfig->octDbRange.min, m_pConfig->octDbRange.max);
+	int max_dB = std::max(m_pConfig->octDbRange.min, m_pConfig->octDbRange.max);
+	int range = std::max(max_dB - min_dB, 4);
 
-	visualizeEnFaceMap(true);
-	visualizeImage(m_pSlider_SelectFrame->value());
+	if ((min_dB >= m_quantDbRange.min) && (max_dB <= m_quantDbRange.max) && (2 * range >= m_quantDbRange.max - m_quantDbRange.min))
+		return false;
+
+	// Margins for adjusting the contrast without quantizing again
+	m_quantDbRange.min = min_dB - range / 4;
+	m_quantDbRange.max = max_dB + range / 4;
+
+	return true;
+}
+
+void QResultTab::applyOctPalette()
+{
+	// Contrast & color table are applied by the palette of the quantized images
+	int ctable_ind = m_pComboBox_OctColorTable->currentIndex();
+	QVector<QRgb> palette = ColorTable::contrastTable(ColorTable::instance().m_colorTableVector.at(ctable_ind),
+		m_quantDbRange.min, m_quantDbRange.max, m_pConfig->octDbRange.min, m_pConfig->octDbRange.max);
+
+	m_pImageView_RectImage->setColorTable(palette);
+	m_pImageView_CircImage->setColorTable(palette);
+	if (m_enFace.currentStatistic() == EnFaceProjection::stdev) // scaled in its own range (no contrast)
+		m_pImageView_OctProjection->setColorTable(ColorTable::instance().m_colorTableVector.at(ctable_ind));
+	else
+		m_pImageView_OctProjection->setColorTable(palette);
+	m_pImageView_ColorbarOctProjection->resetColormap(ColorTable::colortable(ctable_ind));
 }
 
 
@@ -646,15 +771,13 @@ void QResultTab::inBufferDataProcessing()
 		// Set OCT Object ///////////////////////////////////////////////////////////////////////////
 		OCTProcess* pOCT = m_pMainWnd->m_pStreamTab->m_pOCT;
 			
-		// OCT Process //////////////////////////////////////////////////////////////////////////////
+		// OCT Process (en face maps are generated frame by frame) //////////////////////////////////
+		m_frameScheduler.reset(pConfig->nFrames);
 		std::thread oct_proc([&]() { octProcessing(pOCT, pConfig, true); });
 
 		// Wait for threads end /////////////////////////////////////////////////////////////////////
 		oct_proc.join();
 
-		// Generate en face maps ////////////////////////////////////////////////////////////////////
-		getOctProjection(m_vectorOctImage, m_octProjection, m_pConfig->circShift);
-
 		// Delete threading sync buffers ////////////////////////////////////////////////////////////
 		//m_syncOctProcessing.deallocate_queue_buffer();
 
@@ -675,15 +798,18 @@ void QResultTab::inBufferDataProcessing()
 void QResultTab::externalDataProcessing()
 {	
 	// Get path to read
-	QString fileName = QFileDialog::getOpenFileName(nullptr, "Load external OCT data", "", "OCT raw data (*.data)");
+	QString fileName = QFileDialog::getOpenFileName(nullptr, "Load external OCT data", "", "OCT raw data (*.data *.hvd *.cdata)");
 	if (fileName != "")
 	{
 		std::thread t1([&, fileName]() {
 
 			std::chrono::system_clock::time_point start = std::chrono::system_clock::now();
 			
+			bool container = fileName.endsWith(".hvd", Qt::CaseInsensitive) || fileName.endsWith(".cdata", Qt::CaseInsensitive); // *.cdata: read by the container
+
 			QFile file(fileName);
-			if (false == file.open(QFile::ReadOnly))
+			OctDataFile dataFile;
+			if (container ? !dataFile.open(fileName) : !file.open(QFile::ReadOnly))
 				printf("[ERROR] Invalid external data!\n");
 			else
 			{
@@ -698,18 +824,26 @@ void QResultTab::externalDataProcessing()
 				QString bgName = fileTitle + ".background";
 				QString calibName = fileTitle + ".calibration";
 
-				qDebug() << iniName;
-
 				static Configuration config;
-				config.getConfigFile(iniName);
-				if (m_pCheckBox_UserDefinedAlines->isChecked())
+				if (container)
+				{
+					// Configuration snapshot & frame size embedded in the container
+					dataFile.getConfiguration(config);
+				}
+				else
 				{
-					config.nAlines = m_pLineEdit_UserDefinedAlines->text().toInt();
-					config.nAlines4 = ((config.nAlines + 3) >> 2) << 2;
-					config.nFrameSize = config.nScans * config.nAlines;
+					qDebug() << iniName;
+
+					config.getConfigFile(iniName);
+					if (m_pCheckBox_UserDefinedAlines->isChecked())
+					{
+						config.nAlines = m_pLineEdit_UserDefinedAlines->text().toInt();
+						config.nAlines4 = ((config.nAlines + 3) >> 2) << 2;
+						config.nFrameSize = config.nScans * config.nAlines;
+					}
+					config.nFrames = (int)(file.size() / (qint64)config.nScans / (qint64)config.nAlines / sizeof(uint16_t));
 				}
 				config.octDiscomVal = m_pLineEdit_DiscomValue->text().toInt();
-				config.nFrames = (int)(file.size() / (qint64)config.nScans / (qint64)config.nAlines / sizeof(uint16_t));
 				if (m_pCheckBox_SingleFrame->isChecked()) config.nFrames = 1;
 
 				printf("Start external image processing... (Total nFrame: %d)\n", config.nFrames);
@@ -722,37 +856,148 @@ void QResultTab::externalDataProcessing()
 				// Set Buffers //////////////////////////////////////////////////////////////////////////////
 				setObjects(&config);
 
-				int bufferSize = (false == m_pCheckBox_SingleFrame->isChecked()) ? PROCESSING_BUFFER_SIZE : 1;
-				m_syncOctProcessing.allocate_queue_buffer(config.nScans, config.nAlines, bufferSize);
-
-				// Set OCT Object ///////////////////////////////////////////////////////////////////////////
-				OCTProcess* pOCT = new OCTProcess(config.nScans, config.nAlines);
-				pOCT->loadCalibration(calibName.toUtf8().constData(), bgName.toUtf8().constData());
-				pOCT->changeDiscomValue(config.octDiscomVal);
-			
-				// Get external data ////////////////////////////////////////////////////////////////////////
-				std::thread load_data([&]() { loadingRawData(&file, &config); });
+				bool cached = false, reproject = false, writeCache = false;
+#ifdef OCT_RESULT_CACHE
+				// Processed result cache ///////////////////////////////////////////////////////////////////
+				QString cacheName = fileTitle + ".hvr";
+				QByteArray cacheKey;
+				if (!m_pCheckBox_SingleFrame->isChecked())
+				{
+					QByteArray calib, background;
+					if (container)
+					{
+						calib = dataFile.section(OCT_SECTION_CALIBRATION);
+						background = dataFile.section(OCT_SECTION_BACKGROUND);
+					}
+					else
+					{
+						QFile calibFile(calibName), bgFile(bgName);
+						if (calibFile.open(QIODevice::ReadOnly)) calib = calibFile.readAll();
+						if (bgFile.open(QIODevice::ReadOnly)) background = bgFile.readAll();
+					}
+					cacheKey = OctResultCache::key(fileName, calib, background, config.octDiscomVal, config.nScans, config.nAlines);
+
+					// Frames of the cached results are loaded on demand
+					int circShift;
+					cached = OctResultCache::read(cacheName, cacheKey, m_octVolume, m_enFace.projection(EnFaceProjection::maximum), circShift);
+					if (cached)
+					{
+						printf("Cached results are loaded. (%s)\n", cacheName.toLocal8Bit().constData());
+						reproject = (circShift != m_pConfig->circShift) || (m_enFace.currentStatistic() != EnFaceProjection::maximum); // after the first image is shown
+						m_octProjection = m_enFace.projection();
+					}
+				}
+#endif
 
-				// OCT Process //////////////////////////////////////////////////////////////////////////////
-				std::thread oct_proc([&]() { octProcessing(pOCT, &config); });
+				// On-demand processing: the first frame is shown as soon as it is processed, and the rest is processed in the background
+				bool lazy = m_pCheckBox_LazyProcessing->isChecked() && !m_pCheckBox_SingleFrame->isChecked();
+				bool shown = false;
+				m_frameScheduler.reset(config.nFrames, cached);
 
-				// Wait for threads end /////////////////////////////////////////////////////////////////////
-				load_data.join();
-				oct_proc.join();
+				if (!cached)
+				{
+					// Raw data is mapped and read without copy (queue buffers are not needed)
+					MappedRawFile mappedFile;
+					bool mapped = !container && mappedFile.open(fileName, config.nFrameSize);
+
+					int bufferSize = (false == m_pCheckBox_SingleFrame->isChecked()) ? PROCESSING_BUFFER_SIZE : 1;
+					if (!mapped)
+						m_syncOctProcessing.allocate_queue_buffer(config.nScans, config.nAlines, bufferSize);
+
+					// Set OCT Object ///////////////////////////////////////////////////////////////////////////
+					OCTProcess* pOCT = new OCTProcess(config.nScans, config.nAlines);
+					if (container)
+						pOCT->loadCalibrationData(dataFile.section(OCT_SECTION_CALIBRATION), dataFile.section(OCT_SECTION_BACKGROUND));
+					else
+						pOCT->loadCalibration(calibName.toUtf8().constData(), bgName.toUtf8().constData());
+					pOCT->changeDiscomValue(config.octDiscomVal);
+
+					// OCT Process (en face maps are generated frame by frame) //////////////////////////////////
+					m_bLazyProcessing = lazy;
+					m_nFailedFrames = 0;
+					std::thread load_data, oct_proc;
+					if (mapped) // mapped external data
+						oct_proc = std::thread([&]() { octProcessing(pOCT, &config, &mappedFile); });
+					else if (lazy) // random access in the order of the requests
+						oct_proc = std::thread([&]() { octProcessing(pOCT, &config, &file, container ? &dataFile : nullptr); });
+					else
+					{
+						// Get external data ////////////////////////////////////////////////////////////////////
+						load_data = std::thread([&]() { loadingRawData(&file, &config, container ? &dataFile : nullptr); });
+						oct_proc = std::thread([&]() { octProcessing(pOCT, &config); });
+					}
+
+					if (lazy && m_frameScheduler.wait(0))
+					{
+						shown = true;
+						emit setWidgets(true, &config);
+						emit processedLazyFrame(0);
+					}
+
+					// Wait for threads end /////////////////////////////////////////////////////////////////////
+					if (load_data.joinable())
+						load_data.join();
+					oct_proc.join();
+					m_bLazyProcessing = false;
+
+					// Delete OCT FLIM Object & threading sync buffers //////////////////////////////////////////
+					delete pOCT; 
+					if (!mapped)
+						m_syncOctProcessing.deallocate_queue_buffer();
+					mappedFile.close();
+
+#ifdef OCT_RESULT_CACHE
+					// Processed result cache is written only if every frame is processed from the data
+					if (!cacheKey.isEmpty())
+					{
+						if ((m_nProcessedFrames != config.nFrames) || (m_nFailedFrames != 0))
+							printf("Results are not cached. (%d / %d frames processed, %d frames not read)\n", (int)m_nProcessedFrames, config.nFrames, (int)m_nFailedFrames);
+						else
+							writeCache = true;
+					}
+#endif
+				}
 
-				// Generate en face maps ////////////////////////////////////////////////////////////////////
-				getOctProjection(m_vectorOctImage, m_octProjection, m_pConfig->circShift);
+				if (reproject)
+				{
+					// The cached projection (other window or statistic) is projected again from the cached frames in the background
+					m_bLazyProcessing = true;
+					emit setWidgets(true, &config);
+					visualizeEnFaceMap(true);
+					visualizeImage(0);
+
+					m_enFace.setOffset(m_pConfig->circShift, m_octVolume, nullptr);
+					m_octProjection = m_enFace.projection();
+					m_bLazyProcessing = false;
+					emit finishedLazyProcessing();
+				}
+				else if (shown)
+				{
+					// Background processing is finished
+					if (!writeCache)
+						emit finishedLazyProcessing();
+				}
+				else
+				{
+					// Reset Widgets (whole-volume controls are enabled after the cache is written) //////////
+					m_bLazyProcessing = writeCache;
+					emit setWidgets(true, &config);
 
-				// Delete OCT FLIM Object & threading sync buffers //////////////////////////////////////////
-				delete pOCT; 
-				m_syncOctProcessing.deallocate_queue_buffer();
+					// Visualization /////////////////////////////////////////////////////////////////////////
+					visualizeEnFaceMap(true);
+					visualizeImage(0);
+				}
 
-				// Reset Widgets /////////////////////////////////////////////////////////////////////////////
-				emit setWidgets(true, &config);
-		
-				// Visualization /////////////////////////////////////////////////////////////////////////////
-                visualizeEnFaceMap(true);
-				visualizeImage(0);
+#ifdef OCT_RESULT_CACHE
+				// Write processed result cache (after the widgets are enabled) ///////////////////////////////
+				if (writeCache)
+				{
+					if (!OctResultCache::write(cacheName, cacheKey, m_octVolume, m_enFace.projection(EnFaceProjection::maximum), m_enFace.offset()))
+						printf("[WARNING] Failed to write the result cache. (%s)\n", cacheName.toLocal8Bit().constData());
+					m_bLazyProcessing = false;
+					emit finishedLazyProcessing();
+				}
+#endif
 			}
 
 			std::chrono::duration<double> elapsed = std::chrono::system_clock::now() - start;
@@ -775,30 +1020,41 @@ void QResultTab::setWidgetsEnabled(bool enabled, Configuration* pConfig)
 
 		m_pImageView_RectImage->resetSize(pConfig->nAlines4, pConfig->n2ScansFFT);
 		m_pImageView_CircImage->resetSize(2 * CIRC_RADIUS, 2 * CIRC_RADIUS);
+		m_pImageView_CircImage->setDisplaySize(m_circDiameter, m_circDiameter);
 
 		m_pImageView_OctProjection->resetSize(pConfig->nAlines4, pConfig->nFrames);
+		applyOctPalette();
 
 		// Reset widgets
 		m_pImageView_OctProjection->setEnabled(true);        
         m_pImageView_OctProjection->setUpdatesEnabled(true);
 
-		m_pPushButton_StartProcessing->setEnabled(true);
-        if (m_pRadioButton_External->isChecked() && (false == m_pCheckBox_SingleFrame->isChecked()))
-            m_pPushButton_SaveResults->setEnabled(true);
+		if (!m_bLazyProcessing) // until the rest of frames are processed in the background
+		{
+			m_pPushButton_StartProcessing->setEnabled(true);
+			if (m_pRadioButton_External->isChecked() && (false == m_pCheckBox_SingleFrame->isChecked()))
+				m_pPushButton_SaveResults->setEnabled(true);
+		}
 
 		if ((m_pMemBuff->m_nRecordedFrames != 0) && (!m_pMemBuff->m_bIsSaved))
             m_pRadioButton_InBuffer->setEnabled(true);
 		m_pRadioButton_External->setEnabled(true);
 
 		m_pCheckBox_SingleFrame->setEnabled(true);
+		m_pCheckBox_LazyProcessing->setEnabled(true);
 		m_pCheckBox_UserDefinedAlines->setEnabled(true);
 		if (m_pCheckBox_UserDefinedAlines->isChecked())
 			m_pLineEdit_UserDefinedAlines->setEnabled(true);
 		m_pLabel_DiscomValue->setEnabled(true);
 		m_pLineEdit_DiscomValue->setEnabled(true);
 
-		m_pProgressBar_PostProcessing->setFormat("");
-        m_pProgressBar_PostProcessing->setValue(0);
+		if (!m_bLazyProcessing)
+		{
+			m_pProgressBar_PostProcessing->setFormat("");
+			m_pProgressBar_PostProcessing->setValue(0);
+		}
+		else
+			m_pProgressBar_PostProcessing->setFormat("Background processing... %p%");
 
 		if (m_pCheckBox_CircularizeImage->isChecked())
 			m_pToggleButton_MeasureDistance->setEnabled(true);
@@ -809,13 +1065,14 @@ void QResultTab::setWidgetsEnabled(bool enabled, Configuration* pConfig)
 		
 		m_pCheckBox_CircularizeImage->setEnabled(true);
 		m_pCheckBox_ShowGuideLine->setEnabled(true);
-		m_pLabel_CircShift->setEnabled(true);
-		m_pLineEdit_CircShift->setEnabled(true);
+		m_pLabel_CircShift->setEnabled(!m_bLazyProcessing); // whole-volume projections: not while the workers are writing
+		m_pLineEdit_CircShift->setEnabled(!m_bLazyProcessing);
 		m_pLabel_OctColorTable->setEnabled(true);
 		m_pComboBox_OctColorTable->setEnabled(true);
 
 		m_pLineEdit_OctDbMax->setEnabled(true);
 		m_pLineEdit_OctDbMin->setEnabled(true);
+		m_pComboBox_EnFaceStatistic->setEnabled(!m_bLazyProcessing);
 
 #ifdef GALVANO_MIRROR
 		m_pDeviceControlTab->setScrollBarRange(pConfig->nAlines);
@@ -840,6 +1097,7 @@ void QResultTab::setWidgetsEnabled(bool enabled, Configuration* pConfig)
 		m_pRadioButton_External->setDisabled(true);
 
 		m_pCheckBox_SingleFrame->setDisabled(true);
+		m_pCheckBox_LazyProcessing->setDisabled(true);
 		m_pCheckBox_UserDefinedAlines->setDisabled(true);
 		m_pLineEdit_UserDefinedAlines->setDisabled(true);
 		m_pLabel_DiscomValue->setDisabled(true);
@@ -874,6 +1132,7 @@ void QResultTab::setWidgetsEnabled(bool enabled, Configuration* pConfig)
 
 		m_pLineEdit_OctDbMax->setDisabled(true);
 		m_pLineEdit_OctDbMin->setDisabled(true);
+		m_pComboBox_EnFaceStatistic->setDisabled(true);
 
 #ifdef GALVANO_MIRROR
 		m_pDeviceControlTab->setScrollBarEnabled(false);
@@ -900,6 +1159,7 @@ void QResultTab::setWidgetsEnabled(bool enabled)
 		m_pRadioButton_External->setEnabled(true);
 
 		m_pCheckBox_SingleFrame->setEnabled(true);
+		m_pCheckBox_LazyProcessing->setEnabled(true);
 		m_pCheckBox_UserDefinedAlines->setEnabled(true);
 		if (m_pCheckBox_UserDefinedAlines->isChecked())
 			m_pLineEdit_UserDefinedAlines->setEnabled(true);
@@ -915,13 +1175,14 @@ void QResultTab::setWidgetsEnabled(bool enabled)
 
 		m_pCheckBox_CircularizeImage->setEnabled(true);
 		m_pCheckBox_ShowGuideLine->setEnabled(true);
-		m_pLabel_CircShift->setEnabled(true);
-		m_pLineEdit_CircShift->setEnabled(true);
+		m_pLabel_CircShift->setEnabled(!m_bLazyProcessing); // whole-volume projections: not while the workers are writing
+		m_pLineEdit_CircShift->setEnabled(!m_bLazyProcessing);
 		m_pLabel_OctColorTable->setEnabled(true);
 		m_pComboBox_OctColorTable->setEnabled(true);
 
 		m_pLineEdit_OctDbMax->setEnabled(true);
 		m_pLineEdit_OctDbMin->setEnabled(true);
+		m_pComboBox_EnFaceStatistic->setEnabled(!m_bLazyProcessing);
 
 #ifdef GALVANO_MIRROR
 		m_pDeviceControlTab->setScrollBarEnabled(true);
@@ -941,13 +1202,14 @@ void QResultTab::setWidgetsEnabled(bool enabled)
 		m_pRadioButton_External->setDisabled(true);
 
 		m_pCheckBox_SingleFrame->setDisabled(true);
+		m_pCheckBox_LazyProcessing->setDisabled(true);
 		m_pCheckBox_UserDefinedAlines->setDisabled(true);
 		m_pLineEdit_UserDefinedAlines->setDisabled(true);
 		m_pLabel_DiscomValue->setDisabled(true);
 		m_pLineEdit_DiscomValue->setDisabled(true);
 
 		m_pProgressBar_PostProcessing->setFormat("Saving results... %p%");
-		m_pProgressBar_PostProcessing->setRange(0, (int)m_vectorOctImage.size() * 2 - 1);
+		m_pProgressBar_PostProcessing->setRange(0, m_octVolume.size() * 2 - 1);
 		m_pProgressBar_PostProcessing->setValue(0);
 
 		m_pToggleButton_MeasureDistance->setDisabled(true);
@@ -963,6 +1225,7 @@ void QResultTab::setWidgetsEnabled(bool enabled)
 
 		m_pLineEdit_OctDbMax->setDisabled(true);
 		m_pLineEdit_OctDbMin->setDisabled(true);
+		m_pComboBox_EnFaceStatistic->setDisabled(true);
 
 #ifdef GALVANO_MIRROR
 		m_pDeviceControlTab->setScrollBarEnabled(false);
@@ -972,38 +1235,36 @@ void QResultTab::setWidgetsEnabled(bool enabled)
 
 void QResultTab::setObjects(Configuration* pConfig)
 {
-	// Clear existed buffers
-	std::vector<np::FloatArray2> clear_vector;
-	clear_vector.swap(m_vectorOctImage);
-
-	// Data buffers
-	for (int i = 0; i < pConfig->nFrames; i++)
-	{
-		np::FloatArray2 buffer = np::FloatArray2(pConfig->n2ScansFFT, pConfig->nAlines4);
-		m_vectorOctImage.push_back(buffer);
-	}
-	m_octProjection = np::FloatArray2(pConfig->nAlines4, pConfig->nFrames);
+	// Data buffers (existed buffers are cleared)
+	m_renderCache.clear();
+	m_enFace.allocate(pConfig->nAlines4, pConfig->nFrames, m_pConfig->circShift);
+	size_t budget = (size_t)VOLUME_MEMORY_BUDGET << 20; // en face statistics are in the budget as well
+	m_octVolume.setMemoryBudget(budget - std::min(m_enFace.memoryUsage(), budget));
+	m_octVolume.allocate(pConfig->n2ScansFFT, pConfig->nAlines4, pConfig->nFrames);
+	m_octProjection = m_enFace.projection();
 
 	// Visualization buffers
-	ColorTable temp_ctable;
+	const ColorTable& temp_ctable = ColorTable::instance();
+	updateQuantRange();
 
 	if (m_pImgObjRectImage) delete m_pImgObjRectImage;
 	m_pImgObjRectImage = new ImageObject(pConfig->nAlines4, pConfig->n2ScansFFT, temp_ctable.m_colorTableVector.at(m_pComboBox_OctColorTable->currentIndex()));
 	if (m_pImgObjCircImage) delete m_pImgObjCircImage;
-	m_pImgObjCircImage = new ImageObject(2 * CIRC_RADIUS, 2 * CIRC_RADIUS, temp_ctable.m_colorTableVector.at(m_pComboBox_OctColorTable->currentIndex()));
+	m_pImgObjCircImage = new ImageObject(m_circDiameter, m_circDiameter, temp_ctable.m_colorTableVector.at(m_pComboBox_OctColorTable->currentIndex()));
 
 	// En face map visualization buffers
 	m_visOctProjection = np::Uint8Array2(pConfig->nAlines4, pConfig->nFrames);
+	memset(m_visOctProjection.raw_ptr(), 0, sizeof(uint8_t) * m_visOctProjection.length()); // filled progressively (lazy processing)
 
-	// Circ & Medfilt objects
+	// Circ object
     if (m_pCirc) delete m_pCirc;
     m_pCirc = new circularize(CIRC_RADIUS, pConfig->nAlines, false);
 
-	if (m_pMedfiltRect) delete m_pMedfiltRect;
-    m_pMedfiltRect = new medfilt(pConfig->nAlines4, pConfig->n2ScansFFT, 3, 3);
+	// Render cache (only the processed frames are rendered)
+	m_renderCache.allocate(pConfig->n2ScansFFT, pConfig->nAlines4, m_pCirc, [&](int frame) { return m_frameScheduler.isDone(frame); });
 }
 
-void QResultTab::loadingRawData(QFile* pFile, Configuration* pConfig)
+void QResultTab::loadingRawData(QFile* pFile, Configuration* pConfig, OctDataFile* pDataFile)
 {
 	int frameCount = 0;
 
@@ -1025,7 +1286,17 @@ void QResultTab::loadingRawData(QFile* pFile, Configuration* pConfig)
 			if (frame_data)
 			{
 				// Read data from the external data 
-				pFile->read(reinterpret_cast<char *>(frame_data), sizeof(uint16_t) * pConfig->nFrameSize);
+				if (pDataFile)
+				{
+					if (!pDataFile->readFrame(frameCount, frame_data))
+					{
+						memset(frame_data, 0, sizeof(uint16_t) * pConfig->nFrameSize);
+						m_nFailedFrames++;
+					}
+				}
+				else if (pFile->read(reinterpret_cast<char *>(frame_data), sizeof(uint16_t) * pConfig->nFrameSize) != (qint64)(sizeof(uint16_t) * pConfig->nFrameSize))
+					m_nFailedFrames++;
+				frame_header(frame_data)->seq = (uint32_t)frameCount;
 				frameCount++;
 
 				// Push the buffers to sync Queues
@@ -1033,76 +1304,162 @@ void QResultTab::loadingRawData(QFile* pFile, Configuration* pConfig)
 			}
 		} while (frame_data == nullptr);
 	}
+
+	// End of data (for the processing workers)
+	m_syncOctProcessing.Queue_sync.push(nullptr);
 }
 
 void QResultTab::octProcessing(OCTProcess* pOCT, Configuration* pConfig, bool inBuffer)
 {
-	MemoryBuffer* pMemBuff;
-	if (inBuffer)
+	if (!inBuffer)
 	{
-		pMemBuff = m_pMainWnd->m_pOperationTab->m_pMemoryBuffer;
-		pMemBuff->circulation(WRITING_BUFFER_SIZE - pConfig->nFrames);
-	}
+		// Frames in the sync Queue (frame number in the frame header)
+		octProcessing(pOCT, pConfig, 
+			[&](int& frame) -> const uint16_t* {
+				uint16_t* fringe_data = m_syncOctProcessing.Queue_sync.pop();
+				if (fringe_data == nullptr)
+				{
+					m_syncOctProcessing.Queue_sync.push(nullptr); // for the other workers
+					return nullptr;
+				}
+				frame = (int)frame_header(fringe_data)->seq;
+				return fringe_data;
+			},
+			[&](int, const uint16_t* fringe_data) {
+				std::unique_lock<std::mutex> lock(m_syncOctProcessing.mtx);
+				m_syncOctProcessing.queue_buffer.push(const_cast<uint16_t*>(fringe_data));
+			});
 
-	int frameCount = 0;
-	while (frameCount < pConfig->nFrames)
+		// Remove the end-of-data marker
+		m_syncOctProcessing.Queue_sync.pop();
+	}
+	else
 	{
-		// Get the buffer from the previous sync Queue
-		if (!inBuffer)
-		{
-			uint16_t* fringe_data = m_syncOctProcessing.Queue_sync.pop();
-
-			if (fringe_data != nullptr)
-			{
-				// Body
-				(*pOCT)(m_vectorOctImage.at(frameCount), fringe_data);
-				emit processedSingleFrame(frameCount);
+		// Recorded frames in the writing buffer
+		MemoryBuffer* pMemBuff = m_pMainWnd->m_pOperationTab->m_pMemoryBuffer;
+		octProcessing(pOCT, pConfig,
+			[&](int& frame) -> const uint16_t* {
+				frame = m_frameScheduler.next();
+				return (frame >= 0) ? pMemBuff->frame(frame) : nullptr;
+			},
+			[&](int, const uint16_t*) {});
+	}
+}
 
-				frameCount++;
+void QResultTab::octProcessing(OCTProcess* pOCT, Configuration* pConfig, MappedRawFile* pMappedFile)
+{
+	// Zero-copy views of the mapped frames
+	octProcessing(pOCT, pConfig,
+		[&](int& frame) -> const uint16_t* {
+			frame = m_frameScheduler.next();
+			return (frame >= 0) ? pMappedFile->frame(frame) : nullptr;
+		},
+		[&](int frame, const uint16_t*) { pMappedFile->release(frame); });
+}
 
-				// Return (push) the buffer to the previous threading queue
-				{
-					std::unique_lock<std::mutex> lock(m_syncOctProcessing.mtx);
-					m_syncOctProcessing.queue_buffer.push(fringe_data);
-				}
+void QResultTab::octProcessing(OCTProcess* pOCT, Configuration* pConfig, QFile* pFile, OctDataFile* pDataFile)
+{
+	// Random access to the external data in the order of the frame scheduler (buffers in the queue buffer)
+	std::mutex mtxFile;
+	std::condition_variable cvBuffer; // a buffer is returned to the queue buffer
+	qint64 frameBytes = sizeof(uint16_t) * pConfig->nFrameSize;
+	octProcessing(pOCT, pConfig,
+		[&](int& frame) -> const uint16_t* {
+			frame = m_frameScheduler.next();
+			if (frame < 0)
+				return nullptr;
+
+			uint16_t* fringe_data;
+			{
+				std::unique_lock<std::mutex> lock(m_syncOctProcessing.mtx);
+				cvBuffer.wait(lock, [&]() { return !m_syncOctProcessing.queue_buffer.empty(); }); // usually more buffers than workers
+				fringe_data = m_syncOctProcessing.queue_buffer.front();
+				m_syncOctProcessing.queue_buffer.pop();
 			}
-			else
+
+			std::unique_lock<std::mutex> lock(mtxFile);
+			if (pDataFile ? !pDataFile->readFrame(frame, fringe_data)
+				: (!pFile->seek(frameBytes * frame) || (pFile->read(reinterpret_cast<char*>(fringe_data), frameBytes) != frameBytes)))
 			{
-				printf("octProcessing1 is halted.\n");
-				break;
+				memset(fringe_data, 0, frameBytes);
+				m_nFailedFrames++;
 			}
-		}
-		else
-		{
-			// Pop front the buffer from the writing buffer queue
-			uint16_t* fringe_data = pMemBuff->pop_front();
 
-			// Body
-			(*pOCT)(m_vectorOctImage.at(frameCount), fringe_data);
-			emit processedSingleFrame(frameCount);
+			return fringe_data;
+		},
+		[&](int, const uint16_t* fringe_data) {
+			{
+				std::unique_lock<std::mutex> lock(m_syncOctProcessing.mtx);
+				m_syncOctProcessing.queue_buffer.push(const_cast<uint16_t*>(fringe_data));
+			}
+			cvBuffer.notify_one();
+		});
+}
 
-			frameCount++;
+void QResultTab::octProcessing(OCTProcess* pOCT, Configuration* pConfig,
+	const std::function<const uint16_t*(int&)>& getFringe, const std::function<void(int, const uint16_t*)>& returnFringe)
+{
+	// Processing workers (each worker has its own OCTProcess object with the calibration of pOCT)
+	int nWorkers = std::min((int)std::thread::hardware_concurrency(), OFFLINE_PROCESSING_WORKERS);
+	nWorkers = std::max(std::min(nWorkers, pConfig->nFrames), 1);
 
-			// Push back the buffer to the writing buffer queue
-			pMemBuff->push_back(fringe_data);
-		}
+	std::vector<OCTProcess*> vectorOCT(1, pOCT);
+	for (int i = 1; i < nWorkers; i++)
+	{
+		OCTProcess* pWorkerOCT = new OCTProcess(pConfig->nScans, pConfig->nAlines);
+		pWorkerOCT->copyCalibration(*pOCT);
+		vectorOCT.push_back(pWorkerOCT);
 	}
-}
 
+	m_nProcessedFrames = 0;
+	m_lastProgress = std::chrono::steady_clock::now();
 
-void QResultTab::getOctProjection(std::vector<np::FloatArray2>& vecImg, np::FloatArray2& octProj, int offset)
-{
-	int len = CIRC_RADIUS - (offset + PROJECTION_OFFSET);
-	tbb::parallel_for(tbb::blocked_range<size_t>(0, (size_t)vecImg.size()),
-		[&](const tbb::blocked_range<size_t>& r) {
-		for (size_t i = r.begin(); i != r.end(); ++i)
-		{
-			float maxVal;
-			for (int j = 0; j < octProj.size(0); j++)
+	std::vector<std::thread> workers;
+	for (OCTProcess* pWorkerOCT : vectorOCT)
+	{
+		workers.push_back(std::thread([&, pWorkerOCT]() {
+			int frame = 0;
+			const uint16_t* fringe_data;
+			while ((fringe_data = getFringe(frame)) != nullptr)
 			{
-				ippsMax_32f(&vecImg.at((int)i)(offset + PROJECTION_OFFSET, j), len, &maxVal);
-				octProj(j, (int)i) = maxVal;
+				// Body
+				OctVolume::Frame octImage = m_octVolume.at(frame, true);
+				(*pWorkerOCT)(octImage, fringe_data);
+				returnFringe(frame, fringe_data);
+
+				// En face statistics of the frame
+				m_enFace.processFrame(octImage, frame);
+				m_frameScheduler.complete(frame);
+				if (m_bLazyProcessing)
+					emit processedLazyFrame(frame);
+
+				notifyProgress(++m_nProcessedFrames);
 			}
-		}
-	});
+		}));
+	}
+
+	// Wait for workers end
+	for (std::thread& worker : workers)
+		worker.join();
+	m_frameScheduler.finish();
+	notifyProgress(m_nProcessedFrames, true);
+
+	if (m_nProcessedFrames < pConfig->nFrames)
+		printf("octProcessing is halted. (%d / %d)\n", (int)m_nProcessedFrames, pConfig->nFrames);
+
+	for (int i = 1; i < nWorkers; i++)
+		delete vectorOCT.at(i);
+}
+
+void QResultTab::notifyProgress(int nProcessedFrames, bool force)
+{
+	// Throttled progress signal (aggregated over the workers)
+	std::unique_lock<std::mutex> lock(m_mtxProgress);
+
+	std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+	if (force || (now - m_lastProgress > std::chrono::milliseconds(PROGRESS_UPDATE_INTERVAL)))
+	{
+		emit processedSingleFrame(nProcessedFrames - 1);
+		m_lastProgress = now;
+	}
 }
@@ -7,18 +7,29 @@
 
 #include <Havana2/Configuration.h>
 
+#include <functional>
+#include <atomic>
+#include <chrono>
+
 #include <Common/array.h>
 #include <Common/circularize.h>
-#include <Common/medfilt.h>
 #include <Common/SyncObject.h>
+#include <Common/FrameScheduler.h>
 #include <Common/ImageObject.h>
 #include <Common/basic_functions.h>
 
+#include <MemoryBuffer/OctVolume.h>
+#include <MemoryBuffer/RenderCache.h>
+
+#include <DataProcess/EnFaceProjection/EnFaceProjection.h>
+
 class MainWindow;
 #ifdef GALVANO_MIRROR
 class QDeviceControlTab;
 #endif
 class MemoryBuffer;
+class OctDataFile;
+class MappedRawFile;
 
 class QImageView;
 class SaveResultDlg;
@@ -48,6 +59,8 @@ public:
 	inline QImageView* getCircImageView() const { return m_pImageView_CircImage; }
 	inline int getCurrentFrame() const { return m_pSlider_SelectFrame->value(); }
 	inline int getCurrentOctColorTable() const { return m_pComboBox_OctColorTable->currentIndex(); }
+	inline QString getOctProjectionName() const { return EnFaceProjection::name(m_enFace.currentStatistic()); }
+	Range<int> getOctProjectionRange() const; // standard deviation: [0, PROJECTION_STDEV_RANGE]
 	inline void setUserDefinedAlines(int nAlines) { m_pLineEdit_UserDefinedAlines->setText(QString::number(nAlines)); }
 #ifdef GALVANO_MIRROR
 	inline void invalidate() { visualizeEnFaceMap(true); visualizeImage(getCurrentFrame()); }
@@ -58,6 +71,7 @@ private:
     void createDataLoadingWritingTab();
     void createVisualizationOptionTab();
     void createEnFaceMapTab();
+	void resizeCircImage(const QSize& size);
 	
 private slots: // widget operation
 	void changeDataSelection(int id);
@@ -71,6 +85,9 @@ private slots: // widget operation
 	void changeVisImage(bool);
 	void checkCircShift(const QString &);
 	void adjustOctContrast();
+	void changeEnFaceStatistic(int);
+	void visualizeProcessedFrame(int);
+	void finishLazyProcessing();
 
 private slots: // processing
 	void startProcessing();
@@ -89,6 +106,8 @@ signals:
 	void paintOctProjection(uint8_t*);
 
 	void processedSingleFrame(int);
+	void processedLazyFrame(int);
+	void finishedLazyProcessing();
 
 private:
 	void inBufferDataProcessing();
@@ -96,11 +115,17 @@ private:
 
 	void setObjects(Configuration* pConfig);
 
-	void loadingRawData(QFile* pFile, Configuration* pConfig);
+	void loadingRawData(QFile* pFile, Configuration* pConfig, OctDataFile* pDataFile = nullptr);
 	void octProcessing(OCTProcess* pOCT, Configuration* pConfig, bool inBuffer = false);
+	void octProcessing(OCTProcess* pOCT, Configuration* pConfig, MappedRawFile* pMappedFile);
+	void octProcessing(OCTProcess* pOCT, Configuration* pConfig, QFile* pFile, OctDataFile* pDataFile);
+	void octProcessing(OCTProcess* pOCT, Configuration* pConfig,
+		const std::function<const uint16_t*(int&)>& getFringe, const std::function<void(int, const uint16_t*)>& returnFringe);
+	void notifyProgress(int nProcessedFrames, bool force = false);
 
 private:
-	void getOctProjection(std::vector<np::FloatArray2>& vecImg, np::FloatArray2& octProj, int offset);
+	bool updateQuantRange();
+	void applyOctPalette();
 
 // Variables ////////////////////////////////////////////
 private: // main pointer
@@ -114,11 +139,25 @@ private: // main pointer
 private: // for threading operation
 	SyncObject<uint16_t> m_syncOctProcessing;
 
+	std::atomic<int> m_nProcessedFrames;
+	std::atomic<int> m_nFailedFrames; // frames not read (zero-filled), the results are not cached
+	std::mutex m_mtxProgress;
+	std::chrono::steady_clock::time_point m_lastProgress;
+
+	FrameScheduler m_frameScheduler; // order of the processed frames
+	std::atomic<bool> m_bLazyProcessing; // frames are processed on demand after the widgets are enabled
+	std::chrono::steady_clock::time_point m_lastEnFaceUpdate;
+
 public: // for visualization
-	std::vector<np::FloatArray2> m_vectorOctImage;
-	np::FloatArray2 m_octProjection;
+	OctVolume m_octVolume;
+	EnFaceProjection m_enFace; // en face statistics of m_octVolume
+	np::FloatArray2 m_octProjection; // selected statistic of m_enFace
 
 private:
+	RenderCache m_renderCache; // display-ready images of m_octVolume
+	Range<int> m_quantDbRange; // dB range of the quantized images (contrast in it is applied by the palette)
+	int m_circDiameter; // circularized at the viewport resolution (m_pImgObjCircImage as well, m_pCirc: full resolution for saving)
+
 	ImageObject *m_pImgObjRectImage;
 	ImageObject *m_pImgObjCircImage;
 
@@ -126,7 +165,6 @@ private:
 
 public:
 	circularize* m_pCirc;
-	medfilt* m_pMedfiltRect;
 
 
 public:
@@ -156,6 +194,7 @@ private:
 	QLineEdit *m_pLineEdit_UserDefinedAlines;
 
 	QCheckBox *m_pCheckBox_SingleFrame;
+	QCheckBox *m_pCheckBox_LazyProcessing;
 
 	QLabel *m_pLabel_DiscomValue;
 	QLineEdit *m_pLineEdit_DiscomValue;
@@ -182,6 +221,7 @@ private:
     // En face map tab widgets
 	QGroupBox *m_pGroupBox_EnFace;
     QLabel *m_pLabel_OctProjection;
+    QComboBox *m_pComboBox_EnFaceStatistic;
 
     QImageView *m_pImageView_OctProjection;
     QImageView *m_pImageView_ColorbarOctProjection;
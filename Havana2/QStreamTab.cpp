@@ -17,9 +17,11 @@
 #include <Havana2/Dialog/OctCalibDlg.h>
 
 
+
 QStreamTab::QStreamTab(QWidget *parent) :
     QDialog(parent), m_pOctCalibDlg(nullptr), m_pImgObjRectImage(nullptr), m_pImgObjCircImage(nullptr),
-	m_pCirc(nullptr), m_pMedfilt(nullptr)
+	m_pCirc(nullptr), m_circDiameter(2 * CIRC_RADIUS), m_pDisplayKernel(nullptr), m_nLiveFrames(0), m_nLiveDrawnFrames(0), m_bLiveRescale(false), m_bLiveRedraw(false), m_nLastAcquiredFrame(-1), m_frameMonitor(RENEWAL_COUNT),
+	m_pLatestFrame(nullptr), m_nextDisplay(0), m_bDisplayPending(false), m_pLatestFringe(nullptr), m_bFringeVisible(false)
 {
 	// Set main window objects
 	m_pMainWnd = (MainWindow*)parent;
@@ -47,16 +49,25 @@ QStreamTab::QStreamTab(QWidget *parent) :
 	setVisualizationCallback();
 
 	// Create visualization buffers
-	m_visFringe = np::FloatArray2(m_pConfig->nScans, m_pConfig->nAlines);
+	m_visFringe = np::FloatArray(m_pConfig->nScans);
 	m_visImage = np::FloatArray2(m_pConfig->n2ScansFFT, m_pConfig->nAlines);
+	m_visAline = np::FloatArray(m_pConfig->n2ScansFFT);
 
 	// Create image visualization buffers
-	ColorTable temp_ctable;
+	const ColorTable& temp_ctable = ColorTable::instance();
 	m_pImgObjRectImage = new ImageObject(m_pConfig->nAlines, m_pConfig->n2ScansFFT, temp_ctable.m_colorTableVector.at(temp_ctable.gray));
 	m_pImgObjCircImage = new ImageObject(2 * CIRC_RADIUS, 2 * CIRC_RADIUS, temp_ctable.m_colorTableVector.at(temp_ctable.gray));
+
+	// Create live map buffers
+	m_visLiveEnFace = np::Uint8Array2(m_pConfig->nAlines, LIVE_MAP_FRAMES);
+	m_visLiveLMode = np::Uint8Array2(CIRC_RADIUS, LIVE_MAP_FRAMES);
+	m_liveEnFaceDb = np::FloatArray2(m_pConfig->nAlines, LIVE_MAP_FRAMES);
+	m_liveLModeDb = np::FloatArray2(CIRC_RADIUS, LIVE_MAP_FRAMES);
+	memset(m_visLiveEnFace.raw_ptr(), 0, sizeof(uint8_t) * m_visLiveEnFace.length());
+	memset(m_visLiveLMode.raw_ptr(), 0, sizeof(uint8_t) * m_visLiveLMode.length());
 	
 	m_pCirc = new circularize(CIRC_RADIUS, m_pConfig->nAlines, false);
-	m_pMedfilt = new medfilt(m_pConfig->nAlines, m_pConfig->n2ScansFFT, 3, 3);
+	m_pDisplayKernel = new display_kernel(m_pConfig->n2ScansFFT, m_pConfig->nAlines);
 
 
     // Create layout
@@ -108,6 +119,13 @@ QStreamTab::QStreamTab(QWidget *parent) :
 	m_pImageView_CircImage->hide();
     //m_pImageView_CircImage->setVisible(false);
     m_pImageView_CircImage->setMovedMouseCallback([&] (QPoint& p) { m_pMainWnd->m_pStatusLabel_ImagePos->setText(QString("(%1, %2)").arg(p.x(), 4).arg(p.y(), 4)); });
+	m_pImageView_CircImage->setResizedCallback([&](QSize size) { resizeCircImage(size); });
+
+	// Create live map views (en face: A-lines x frames, L-mode: frames x depth at the selected A-line)
+	m_pImageView_LiveEnFace = new QImageView(ColorTable::colortable(m_pConfig->octColorTable), m_pConfig->nAlines, LIVE_MAP_FRAMES);
+	m_pImageView_LiveEnFace->setMinimumSize(175, 175);
+	m_pImageView_LiveLMode = new QImageView(ColorTable::colortable(m_pConfig->octColorTable), LIVE_MAP_FRAMES, CIRC_RADIUS);
+	m_pImageView_LiveLMode->setMinimumSize(175, 175);
 
     // Set layout for right panel
 	QVBoxLayout *pVBoxLayout_RightPanel = new QVBoxLayout;
@@ -117,6 +135,13 @@ QStreamTab::QStreamTab(QWidget *parent) :
 	pVBoxLayout_RightPanel->addWidget(m_pImageView_RectImage);
 	pVBoxLayout_RightPanel->addWidget(m_pImageView_CircImage);
 
+	QHBoxLayout *pHBoxLayout_LiveMaps = new QHBoxLayout;
+	pHBoxLayout_LiveMaps->setSpacing(0);
+	pHBoxLayout_LiveMaps->addWidget(m_pImageView_LiveEnFace);
+	pHBoxLayout_LiveMaps->addWidget(m_pImageView_LiveLMode);
+
+	pVBoxLayout_RightPanel->addItem(pHBoxLayout_LiveMaps);
+
     pHBoxLayout->addItem(pVBoxLayout_RightPanel);
 
     this->setLayout(pHBoxLayout);
@@ -124,18 +149,23 @@ QStreamTab::QStreamTab(QWidget *parent) :
 
 	// Connect signal and slot
 	connect(this, SIGNAL(plotFringe(float*)), m_pScope_OctFringe, SLOT(drawData(float*)));
+	m_pScope_OctFringe->installEventFilter(this);
 	connect(this, SIGNAL(plotAline(float*)), m_pScope_OctDepthProfile, SLOT(drawData(float*)));
 	connect(this, SIGNAL(paintRectImage(uint8_t*)), m_pImageView_RectImage, SLOT(drawImage(uint8_t*)));
-	connect(this, SIGNAL(paintCircImage(uint8_t*)), m_pImageView_CircImage, SLOT(drawImage(uint8_t*)));
+	connect(this, SIGNAL(paintCircImage(uint8_t*, int)), this, SLOT(drawCircImage(uint8_t*, int)));
+	connect(this, SIGNAL(paintLiveMaps(int)), this, SLOT(drawLiveMaps(int)));
 	connect(m_pSlider_SelectAline, SIGNAL(valueChanged(int)), this, SLOT(updateAlinePos(int)));
 }
 
 QStreamTab::~QStreamTab()
 {
+	releaseLatestFringe();
+	releaseLatestFrame();
+
 	if (m_pImgObjRectImage) delete m_pImgObjRectImage;
 	if (m_pImgObjCircImage) delete m_pImgObjCircImage;
 
-	if (m_pMedfilt) delete m_pMedfilt;
+	if (m_pDisplayKernel) delete m_pDisplayKernel;
 	if (m_pCirc) delete m_pCirc;
 
 	if (m_pThreadVisualization) delete m_pThreadVisualization;
@@ -150,6 +180,20 @@ void QStreamTab::keyPressEvent(QKeyEvent *e)
 		QDialog::keyPressEvent(e);
 }
 
+bool QStreamTab::eventFilter(QObject *obj, QEvent *e)
+{
+	// Fringe scope visibility for the visualization thread (QWidget::isVisible is not thread-safe)
+	if (obj == m_pScope_OctFringe)
+	{
+		if (e->type() == QEvent::Show)
+			m_bFringeVisible = true;
+		else if (e->type() == QEvent::Hide)
+			m_bFringeVisible = false;
+	}
+
+	return QDialog::eventFilter(obj, e);
+}
+
 void QStreamTab::setWidgetsText()
 {
 	m_pLineEdit_CircShift->setText(QString::number(m_pConfig->circShift));
@@ -261,6 +305,12 @@ void QStreamTab::setDataAcquisitionCallback()
 #if NIIMAQ_ENABLE
 	m_pDataAcq->ConnectFrameGrabberAcquiredData([&](int frame_count, const np::Array<uint16_t, 2>& frame) {
 
+		// Frame header (carried along with the frame buffers)
+		FrameHeader header = { (uint32_t)frame_count, 0, FrameHeader::now(), { 0, 0 } };
+		if ((m_nLastAcquiredFrame >= 0) && (frame_count != m_nLastAcquiredFrame + 1))
+			header.flags |= FRAME_FLAG_DISCONTINUITY;
+		m_nLastAcquiredFrame = frame_count;
+
 		// Data transfer		
 		if (!(frame_count % RENEWAL_COUNT))
 		{
@@ -284,6 +334,7 @@ void QStreamTab::setDataAcquisitionCallback()
 				// Body
 				int frame_length = m_pConfig->nFrameSize;
 				memcpy(raw_ptr, frame_ptr, sizeof(uint16_t) * frame_length);
+				*frame_header(raw_ptr) = header;
 
 				// Push the buffer to sync Queue
 				m_syncOctProcessing.Queue_sync.push(raw_ptr);
@@ -311,6 +362,7 @@ void QStreamTab::setDataAcquisitionCallback()
 				{
 					// Body (Copying the frame data)
 					memcpy(frame_ptr, frame.raw_ptr(), sizeof(uint16_t) * m_pConfig->nFrameSize);
+					*frame_header(frame_ptr) = header;
 
 					// Push to the copy queue for copying transfered data in copy thread
 					m_pMemBuff->m_syncBuffering.Queue_sync.push(frame_ptr);
@@ -328,6 +380,7 @@ void QStreamTab::setDataAcquisitionCallback()
 
 	m_pDataAcq->ConnectFrameGrabberStopData([&]() {
 		m_syncOctProcessing.Queue_sync.push(nullptr);
+		m_nLastAcquiredFrame = -1;
 	});
 
 	m_pDataAcq->ConnectFrameGrabberSendStatusMessage([&](const char * msg) {
@@ -365,10 +418,7 @@ void QStreamTab::setOctProcessingCallback()
             {
 				// Body
 				(*m_pOCT)(res_ptr, fringe_data);
-
-				// Draw fringe
-				ippsConvert_16u32f(fringe_data, m_visFringe.raw_ptr(), m_visFringe.length());
-				emit plotFringe(&m_visFringe(0, m_pSlider_SelectAline->value()));
+				*frame_header(res_ptr) = *frame_header(fringe_data);
 
 				// Transfer to OCT calibration dlg
 				if (m_pOctCalibDlg)
@@ -377,7 +427,14 @@ void QStreamTab::setOctProcessingCallback()
 				// Push the buffers to sync Queues
 				m_syncVisualization.Queue_sync.push(res_ptr);
 
-				// Return (push) the buffer to the previous threading queue
+				// Keep the raw frame for the fringe scope (converted in the display only)
+				{
+					std::unique_lock<std::mutex> lock(m_mtxFringe);
+					std::swap(m_pLatestFringe, fringe_data);
+				}
+
+				// Return (push) the previous raw frame to the previous threading queue
+				if (fringe_data != nullptr)
 				{
 					std::unique_lock<std::mutex> lock(m_syncOctProcessing.mtx);
 					m_syncOctProcessing.queue_buffer.push(fringe_data);
@@ -409,31 +466,45 @@ void QStreamTab::setVisualizationCallback()
 		float* res_data = m_syncVisualization.Queue_sync.pop();
 		if (res_data != nullptr)
 		{
+			// Pipeline monitoring (latency & dropped frames)
+			m_frameMonitor.update(frame_header(res_data));
+			if (m_frameMonitor.nFrames == PIPELINE_LOG_COUNT)
+			{
+#ifdef PIPELINE_LOG
+				printf("[Pipeline] latency: %.1f ms (max: %.1f ms) / dropped frames: %d / skipped for display: %d\n", 
+					m_frameMonitor.meanLatency(), m_frameMonitor.maxLatency(), m_frameMonitor.nDropped, m_frameMonitor.nSkipped);
+#endif
+				m_frameMonitor.clear();
+			}
+
 			// Body	
+			float* displayed = nullptr;
 			if (m_pOperationTab->isAcquisitionButtonToggled()) // Only valid if acquisition is running
             {
-				// Draw A-lines
-				m_visImage = np::FloatArray2(res_data, m_pConfig->n2ScansFFT, m_pConfig->nAlines);
+				// Live maps (every frame)
+				updateLiveMaps(res_data);
 
-				// Circ Shift
-				for (int i = 0; i < m_pConfig->nAlines; i++)
+				// Mailbox: the newest frame replaces the one not displayed yet
 				{
-					float* pImg = m_visImage.raw_ptr() + i * m_pConfig->n2ScansFFT;
-					std::rotate(pImg, pImg + (m_pConfig->n2ScansFFT - m_pConfig->circShift), pImg + m_pConfig->n2ScansFFT);
-					memset(pImg, 0, sizeof(float) * m_pConfig->circShift);
+					std::unique_lock<std::mutex> lock(m_mtxLatestFrame);
+					std::swap(m_pLatestFrame, res_data);
 				}
+				if (res_data != nullptr)
+					m_frameMonitor.nSkipped++;
 
-				emit plotAline(&m_visImage(0, m_pSlider_SelectAline->value()));
-
-                // Draw Images
-                visualizeImage(m_visImage.raw_ptr());
+				// Displayed at DISPLAY_RATE, and only after the previous frame is painted (no queued paints in the GUI thread)
+				displayed = takeLatestFrame();
 			}
 
 			// Return (push) the buffer to the previous threading queue
+			if (res_data != nullptr)
 			{
 				std::unique_lock<std::mutex> lock(m_syncVisualization.mtx);
 				m_syncVisualization.queue_buffer.push(res_data);
 			}
+
+			if (displayed != nullptr)
+				displayFrame(displayed);
 		}
 		else
 		{
@@ -447,6 +518,11 @@ void QStreamTab::setVisualizationCallback()
 				} while (res_temp != nullptr);
 			}
 
+			// Frame not displayed before the stop (otherwise shown by flushLatestFrame after the previous paint)
+			float* displayed = takeLatestFrame(true);
+			if (displayed != nullptr)
+				displayFrame(displayed);
+
 			m_pThreadVisualization->_running = false;
 
             (void)frame_count;
@@ -475,6 +551,8 @@ void QStreamTab::resetObjectsForAline(int nAlines) // need modification
 	}
 
 	// Create buffers for threading operation
+	releaseLatestFringe();
+	releaseLatestFrame();
 	m_pMemBuff->m_syncBuffering.deallocate_queue_buffer();
 	m_syncOctProcessing.deallocate_queue_buffer();
 	m_syncVisualization.deallocate_queue_buffer();
@@ -492,25 +570,33 @@ void QStreamTab::resetObjectsForAline(int nAlines) // need modification
 #endif
 	
 	// Create visualization buffers
-	m_visFringe = np::FloatArray2(m_pConfig->nScans, nAlines);
 	m_visImage = np::FloatArray2(m_pConfig->n2ScansFFT, nAlines);
 
 	// Create image visualization buffers
-	ColorTable temp_ctable;
 	if (m_pImgObjRectImage) delete m_pImgObjRectImage;
-	m_pImgObjRectImage = new ImageObject(nAlines, m_pConfig->n2ScansFFT, temp_ctable.m_colorTableVector.at(m_pComboBox_OctColorTable->currentIndex()));
+	m_pImgObjRectImage = new ImageObject(nAlines, m_pConfig->n2ScansFFT, ColorTable::instance().m_colorTableVector.at(m_pComboBox_OctColorTable->currentIndex()));
+
+	// Create live map buffers
+	m_visLiveEnFace = np::Uint8Array2(nAlines, LIVE_MAP_FRAMES);
+	m_liveEnFaceDb = np::FloatArray2(nAlines, LIVE_MAP_FRAMES);
+	memset(m_visLiveEnFace.raw_ptr(), 0, sizeof(uint8_t) * m_visLiveEnFace.length());
+	memset(m_visLiveLMode.raw_ptr(), 0, sizeof(uint8_t) * m_visLiveLMode.length());
+	m_nLiveFrames = 0;
+	m_nLiveDrawnFrames = 0;
 
+	m_pImageView_LiveEnFace->resetSize(nAlines, LIVE_MAP_FRAMES);
+	m_pImageView_LiveLMode->resetSize(LIVE_MAP_FRAMES, CIRC_RADIUS);
 
 	// Create circularize object
 	if (m_pCirc)
 	{
 		delete m_pCirc;
-		m_pCirc = new circularize(CIRC_RADIUS, nAlines, false);
+		m_pCirc = new circularize(CIRC_RADIUS, nAlines, false, m_circDiameter);
 	}
-	if (m_pMedfilt)
+	if (m_pDisplayKernel)
 	{
-		delete m_pMedfilt;
-		m_pMedfilt = new medfilt(nAlines, m_pConfig->n2ScansFFT, 3, 3);
+		delete m_pDisplayKernel;
+		m_pDisplayKernel = new display_kernel(m_pConfig->n2ScansFFT, nAlines);
 	}
 
 	// Reset slider range
@@ -523,23 +609,13 @@ void QStreamTab::resetObjectsForAline(int nAlines) // need modification
 
 void QStreamTab::visualizeImage(float* res)
 {
-	IppiSize roi_oct = { m_pConfig->n2ScansFFT, m_pConfig->nAlines };
-	
-	// OCT Visualization
-	np::Uint8Array2 scale_temp(roi_oct.width, roi_oct.height);
-	ippiScale_32f8u_C1R(res, roi_oct.width * sizeof(float), scale_temp.raw_ptr(), roi_oct.width * sizeof(uint8_t), roi_oct, m_pConfig->octDbRange.min, m_pConfig->octDbRange.max);
-	ippiTranspose_8u_C1R(scale_temp.raw_ptr(), roi_oct.width * sizeof(uint8_t), m_pImgObjRectImage->arr.raw_ptr(), roi_oct.height * sizeof(uint8_t), roi_oct);
+	// OCT Visualization (scaling, circ shift, transpose, galvo shift & median filtering in a pass)
+	int galvoShift = 0;
 #ifdef GALVANO_MIRROR
-	if (m_pConfig->galvoHorizontalShift)
-	{
-		for (int i = 0; i < m_pConfig->n2ScansFFT; i++)
-		{
-			uint8_t* pImg = m_pImgObjRectImage->arr.raw_ptr() + i * m_pConfig->nAlines;
-			std::rotate(pImg, pImg + m_pConfig->galvoHorizontalShift, pImg + m_pConfig->nAlines);
-		}
-	}
+	galvoShift = m_pConfig->galvoHorizontalShift;
 #endif
-	(*m_pMedfilt)(m_pImgObjRectImage->arr.raw_ptr());	
+	(*m_pDisplayKernel)(res, m_pImgObjRectImage->arr.raw_ptr(), (float)m_pConfig->octDbRange.min, (float)m_pConfig->octDbRange.max,
+		m_pConfig->circShift, galvoShift);
 
 
 	if (!m_pCheckBox_CircularizeImage->isChecked()) // rect image 
@@ -548,19 +624,223 @@ void QStreamTab::visualizeImage(float* res)
 	}
 	else // circ image
     {
+		// Circularized at the viewport resolution (the map is rebuilt if the view is resized)
+		int diameter = m_circDiameter;
+		if (m_pCirc->diameter != diameter)
+		{
+			delete m_pCirc;
+			m_pCirc = new circularize(CIRC_RADIUS, m_pConfig->nAlines, false, diameter);
+		}
+
 		(*m_pCirc)(m_pImgObjRectImage->arr, m_pImgObjCircImage->arr.raw_ptr(), "vertical", 0);
-		emit paintCircImage(m_pImgObjCircImage->qindeximg.bits());
+		emit paintCircImage(m_pImgObjCircImage->qindeximg.bits(), diameter);
 	}
 }
 
+void QStreamTab::resizeCircImage(const QSize& size)
+{
+	// Display resolution: multiple of 4 (no padding in the scan lines), no larger than the full resolution
+	// The view is resized with the first image rendered at the new diameter (drawCircImage).
+	int diameter = std::max(std::min(std::min(size.width(), size.height()), 2 * CIRC_RADIUS) / 4 * 4, 4);
+	if (diameter == m_circDiameter)
+		return;
+
+	m_circDiameter = diameter;
+
+	if (!m_pOperationTab->isAcquisitionButtonToggled() && m_pCheckBox_CircularizeImage->isChecked())
+		visualizeImage(m_visImage.raw_ptr());
+}
+
+void QStreamTab::drawCircImage(uint8_t* pImage, int diameter)
+{
+	// The image & the view are of the same diameter (an image rendered before a resize is not drawn in the resized view)
+	m_pImageView_CircImage->setDisplaySize(diameter, diameter);
+	m_pImageView_CircImage->drawImage(pImage);
+}
+
+
+float* QStreamTab::takeLatestFrame(bool force)
+{
+	// The mailbox frame is taken if the previous frame is painted and the display interval has elapsed (or forced)
+	std::unique_lock<std::mutex> lock(m_mtxLatestFrame);
+	int64_t now = FrameHeader::now();
+	if ((m_pLatestFrame == nullptr) || m_bDisplayPending || (!force && (now < m_nextDisplay)))
+		return nullptr;
+
+	m_nextDisplay = now + 1000000 / DISPLAY_RATE;
+	m_bDisplayPending = true;
+
+	float* res = m_pLatestFrame;
+	m_pLatestFrame = nullptr;
+
+	return res;
+}
+
+void QStreamTab::displayFrame(float* res)
+{
+	// Draw A-lines
+	m_visImage = np::FloatArray2(res, m_pConfig->n2ScansFFT, m_pConfig->nAlines);
+
+	// Circ shift is applied only to the plotted A-line (& by index in visualizeImage)
+	plotShiftedAline();
+	if (m_bFringeVisible)
+		plotSelectedFringe();
+
+	// Draw Images
+	visualizeImage(m_visImage.raw_ptr());
+	emit paintLiveMaps(m_nLiveFrames);
+
+	// Return (push) the buffer to the previous threading queue
+	std::unique_lock<std::mutex> lock(m_syncVisualization.mtx);
+	m_syncVisualization.queue_buffer.push(res);
+}
+
+void QStreamTab::releaseLatestFrame()
+{
+	std::unique_lock<std::mutex> lock(m_mtxLatestFrame);
+	if (m_pLatestFrame != nullptr)
+	{
+		std::unique_lock<std::mutex> lock_buffer(m_syncVisualization.mtx);
+		m_syncVisualization.queue_buffer.push(m_pLatestFrame);
+		m_pLatestFrame = nullptr;
+	}
+}
+
+void QStreamTab::plotShiftedAline()
+{
+	// Selected A-line with circ shift (the image is not shifted)
+	int circShift = std::min(std::max(m_pConfig->circShift, 0), m_pConfig->n2ScansFFT);
+	memset(m_visAline.raw_ptr(), 0, sizeof(float) * circShift);
+	memcpy(m_visAline.raw_ptr() + circShift, &m_visImage(0, m_pSlider_SelectAline->value()), sizeof(float) * (m_pConfig->n2ScansFFT - circShift));
+
+	emit plotAline(m_visAline.raw_ptr());
+}
+
+void QStreamTab::plotSelectedFringe()
+{
+	// Only the selected A-line of the latest raw frame is converted
+	{
+		std::unique_lock<std::mutex> lock(m_mtxFringe);
+		if (m_pLatestFringe == nullptr)
+			return;
+
+		ippsConvert_16u32f(m_pLatestFringe + m_pSlider_SelectAline->value() * m_pConfig->nScans, m_visFringe.raw_ptr(), m_pConfig->nScans);
+	}
+
+	emit plotFringe(m_visFringe.raw_ptr());
+}
+
+void QStreamTab::releaseLatestFringe()
+{
+	std::unique_lock<std::mutex> lock(m_mtxFringe);
+	if (m_pLatestFringe != nullptr)
+	{
+		std::unique_lock<std::mutex> lock_buffer(m_syncOctProcessing.mtx);
+		m_syncOctProcessing.queue_buffer.push(m_pLatestFringe);
+		m_pLatestFringe = nullptr;
+	}
+}
+
+void QStreamTab::updateLiveMaps(const float* res)
+{
+	// Only a row & a column are updated per frame (sweep display: the oldest frame is overwritten)
+	int frame = m_nLiveFrames++ % LIVE_MAP_FRAMES;
+	int nAlines = m_visLiveEnFace.size(0);
+	int depth = m_pConfig->n2ScansFFT;
+	int circShift = std::min(std::max(m_pConfig->circShift, 0), CIRC_RADIUS);
+
+	// En face map: maximum projection of [circShift + PROJECTION_OFFSET, CIRC_RADIUS)
+	int offset = circShift + PROJECTION_OFFSET;
+	int len = CIRC_RADIUS - offset;
+	float* pRowDb = &m_liveEnFaceDb(0, frame);
+	for (int i = 0; i < nAlines; i++)
+	{
+		if (len > 0)
+			ippsMax_32f(res + i * depth + offset, len, &pRowDb[i]);
+		else
+			pRowDb[i] = 0.0f;
+	}
+#ifdef GALVANO_MIRROR
+	if (m_pConfig->galvoHorizontalShift)
+		std::rotate(pRowDb, pRowDb + m_pConfig->galvoHorizontalShift, pRowDb + nAlines);
+#endif
+
+	// L-mode map: depth profile of the selected A-line (as shown in the B-scan image)
+	int aline = std::min(m_pSlider_SelectAline->value(), nAlines - 1);
+	float* pColDb = &m_liveLModeDb(0, frame);
+	memset(pColDb, 0, sizeof(float) * circShift);
+	memcpy(pColDb + circShift, res + aline * depth, sizeof(float) * (CIRC_RADIUS - circShift));
+
+	// Contrast changed: all the rows & columns are scaled again (in this thread, not while a row is written)
+	if (m_bLiveRescale.exchange(false))
+	{
+		rescaleLiveMaps();
+		return;
+	}
+
+	IppiSize roi_row = { nAlines, 1 };
+	ippiScale_32f8u_C1R(pRowDb, sizeof(float) * nAlines, &m_visLiveEnFace(0, frame), sizeof(uint8_t) * nAlines, roi_row, m_pConfig->octDbRange.min, m_pConfig->octDbRange.max);
+
+	IppiSize roi_col = { CIRC_RADIUS, 1 };
+	ippiScale_32f8u_C1R(pColDb, sizeof(float) * CIRC_RADIUS, &m_visLiveLMode(0, frame), sizeof(uint8_t) * CIRC_RADIUS, roi_col, m_pConfig->octDbRange.min, m_pConfig->octDbRange.max);
+}
+
+void QStreamTab::rescaleLiveMaps()
+{
+	// Frames written so far (the sweep starts from the first row & column)
+	int nFrames = std::min(m_nLiveFrames, LIVE_MAP_FRAMES);
+	if (nFrames == 0)
+		return;
+
+	int nAlines = m_visLiveEnFace.size(0);
+	IppiSize roi_enface = { nAlines, nFrames };
+	ippiScale_32f8u_C1R(m_liveEnFaceDb.raw_ptr(), sizeof(float) * nAlines, m_visLiveEnFace.raw_ptr(), sizeof(uint8_t) * nAlines, roi_enface, m_pConfig->octDbRange.min, m_pConfig->octDbRange.max);
+
+	IppiSize roi_lmode = { CIRC_RADIUS, nFrames };
+	ippiScale_32f8u_C1R(m_liveLModeDb.raw_ptr(), sizeof(float) * CIRC_RADIUS, m_visLiveLMode.raw_ptr(), sizeof(uint8_t) * CIRC_RADIUS, roi_lmode, m_pConfig->octDbRange.min, m_pConfig->octDbRange.max);
+
+	m_bLiveRedraw = true;
+}
+
+void QStreamTab::drawLiveMaps(int nFrames)
+{
+	// Rows & columns of the frames since the previous display (or all of them after a contrast change)
+	// Each row & column only invalidates the view: the whole view is converted & scaled once on the next paint.
+	int first = m_bLiveRedraw.exchange(false) ? 0 : m_nLiveDrawnFrames;
+	for (int n = std::max(first, nFrames - LIVE_MAP_FRAMES); n < nFrames; n++)
+	{
+		int frame = n % LIVE_MAP_FRAMES;
+		m_pImageView_LiveEnFace->drawImageRow(&m_visLiveEnFace(0, frame), frame);
+		m_pImageView_LiveLMode->drawImageColumn(&m_visLiveLMode(0, frame), frame);
+	}
+	m_nLiveDrawnFrames = nFrames;
+
+	int frame = (nFrames - 1) % LIVE_MAP_FRAMES;
+	m_pImageView_LiveEnFace->setHorizontalLine(1, frame + 1);
+	m_pImageView_LiveLMode->setVerticalLine(1, frame + 1);
+
+	// Emitted after the images, so the displayed frame is painted (the next one can be visualized)
+	m_bDisplayPending = false;
+
+	// A frame left in the mailbox is shown after the display interval even if no new frame arrives (stall or stop)
+	QTimer::singleShot(1000 / DISPLAY_RATE + 1, this, SLOT(flushLatestFrame()));
+}
+
+void QStreamTab::flushLatestFrame()
+{
+	// Nothing if the visualization thread has displayed a newer frame meanwhile
+	float* displayed = takeLatestFrame();
+	if (displayed != nullptr)
+		displayFrame(displayed);
+}
 
 void QStreamTab::updateAlinePos(int aline)
 {
 	// Reset channel data
 	if (!m_pOperationTab->isAcquisitionButtonToggled())
 	{
-		emit plotFringe(&m_visFringe(0, m_pSlider_SelectAline->value()));
-		emit plotAline(&m_visImage(0, m_pSlider_SelectAline->value()));
+		plotSelectedFringe();
+		plotShiftedAline();
 	}
 
 	// Reset slider label
@@ -588,15 +868,18 @@ void QStreamTab::changeVisImage(bool toggled)
 void QStreamTab::checkCircShift(const QString &str)
 {
 	int circShift = str.toInt();
-	if (circShift > CIRC_RADIUS - PROJECTION_OFFSET)
+	if ((circShift < 0) || (circShift > CIRC_RADIUS - PROJECTION_OFFSET))
 	{
-		circShift = CIRC_RADIUS - PROJECTION_OFFSET;
+		circShift = std::min(std::max(circShift, 0), CIRC_RADIUS - PROJECTION_OFFSET);
 		m_pLineEdit_CircShift->setText(QString::number(circShift));
 	}
 	m_pConfig->circShift = circShift;
 
 	if (!m_pOperationTab->isAcquisitionButtonToggled())
+	{
+		plotShiftedAline();
 		visualizeImage(m_visImage.raw_ptr());
+	}
 }
 
 void QStreamTab::changeOctColorTable(int ctable_ind)
@@ -605,13 +888,14 @@ void QStreamTab::changeOctColorTable(int ctable_ind)
 
 	m_pImageView_RectImage->resetColormap(ColorTable::colortable(ctable_ind));
 	m_pImageView_CircImage->resetColormap(ColorTable::colortable(ctable_ind));
+	m_pImageView_LiveEnFace->resetColormap(ColorTable::colortable(ctable_ind));
+	m_pImageView_LiveLMode->resetColormap(ColorTable::colortable(ctable_ind));
 	m_pImageView_OctDbColorbar->resetColormap(ColorTable::colortable(ctable_ind));
 
-	ColorTable temp_ctable;
-	if (m_pImgObjRectImage) delete m_pImgObjRectImage;
-	m_pImgObjRectImage = new ImageObject(m_pImageView_RectImage->getRender()->m_pImage->width(), m_pImageView_RectImage->getRender()->m_pImage->height(), temp_ctable.m_colorTableVector.at(ctable_ind));
-	if (m_pImgObjCircImage) delete m_pImgObjCircImage;
-	m_pImgObjCircImage = new ImageObject(m_pImageView_CircImage->getRender()->m_pImage->width(), m_pImageView_CircImage->getRender()->m_pImage->height(), temp_ctable.m_colorTableVector.at(ctable_ind));
+	// Image objects are reused (color tables from the registry)
+	const QVector<QRgb>& ctable = ColorTable::instance().m_colorTableVector.at(ctable_ind);
+	m_pImgObjRectImage->setColorTable(ctable);
+	m_pImgObjCircImage->setColorTable(ctable);
 
 	if (!m_pOperationTab->isAcquisitionButtonToggled())	
 		visualizeImage(m_visImage.raw_ptr());
@@ -631,9 +915,15 @@ void QStreamTab::adjustOctContrast()
 
 	if (!m_pOperationTab->isAcquisitionButtonToggled())	
 	{
-		emit plotAline(&m_visImage(0, m_pSlider_SelectAline->value()));
+		plotShiftedAline();
 		visualizeImage(m_visImage.raw_ptr());
+
+		rescaleLiveMaps();
+		if (m_nLiveFrames > 0)
+			drawLiveMaps(m_nLiveFrames);
 	}
+	else
+		m_bLiveRescale = true;
 }
 
 void QStreamTab::createOctCalibDlg()
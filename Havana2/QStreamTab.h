@@ -5,11 +5,13 @@
 #include <QtWidgets>
 #include <QtCore>
 
+#include <atomic>
+
 #include <Havana2/Configuration.h>
 
 #include <Common/array.h>
 #include <Common/circularize.h>
-#include <Common/medfilt.h>
+#include <Common/display_kernel.h>
 #include <Common/SyncObject.h>
 #include <Common/ImageObject.h>
 #include <Common/basic_functions.h>
@@ -40,6 +42,7 @@ public:
 // Methods //////////////////////////////////////////////
 protected:
 	void keyPressEvent(QKeyEvent *);
+	bool eventFilter(QObject *, QEvent *);
 
 public:
 	inline MainWindow* getMainWnd() const { return m_pMainWnd; }
@@ -66,12 +69,26 @@ public:
 	void resetObjectsForAline(int nAlines);
 	void visualizeImage(float* res); 
 
+private:
+	void updateLiveMaps(const float* res);
+	void rescaleLiveMaps();
+	float* takeLatestFrame(bool force = false);
+	void displayFrame(float* res);
+	void releaseLatestFrame();
+	void plotShiftedAline();
+	void plotSelectedFringe();
+	void releaseLatestFringe();
+	void resizeCircImage(const QSize& size);
+
 private slots:
 	void updateAlinePos(int);
 	void changeVisImage(bool);
 	void checkCircShift(const QString &);
 	void changeOctColorTable(int);
 	void adjustOctContrast();	
+	void drawCircImage(uint8_t*, int);
+	void drawLiveMaps(int);
+	void flushLatestFrame();
 	void createOctCalibDlg();
 	void deleteOctCalibDlg();
 
@@ -79,7 +96,8 @@ signals:
 	void plotFringe(float*);
 	void plotAline(float*);
 	void paintRectImage(uint8_t*);
-	void paintCircImage(uint8_t*);
+	void paintCircImage(uint8_t*, int);
+	void paintLiveMaps(int);
 
 
 // Variables ////////////////////////////////////////////
@@ -105,16 +123,42 @@ private:
 	SyncObject<uint16_t> m_syncOctProcessing;
 	SyncObject<float> m_syncVisualization;
 
+	int m_nLastAcquiredFrame;
+	FrameMonitor m_frameMonitor;
+
+	// Display mailbox (latest frame wins: older frames are skipped for the display only)
+	float* m_pLatestFrame; // newest processed frame not displayed yet
+	int64_t m_nextDisplay; // [us]
+	std::atomic<bool> m_bDisplayPending; // the previous frame is not painted yet
+	std::mutex m_mtxLatestFrame;
+
+	// Latest raw frame for the fringe scope (held out of the processing queue until the next frame)
+	uint16_t* m_pLatestFringe;
+	std::mutex m_mtxFringe;
+	std::atomic<bool> m_bFringeVisible; // visibility of the fringe scope (updated in the GUI thread)
+
 public:
 	// Visualization buffers
-	np::FloatArray2 m_visFringe;
-	np::FloatArray2 m_visImage;
+	np::FloatArray m_visFringe; // selected A-line of the latest raw frame
+	np::FloatArray2 m_visImage; // circShift is applied in visualizeImage (not shifted)
+	np::FloatArray m_visAline; // selected A-line (shifted)
 	
 	ImageObject *m_pImgObjRectImage;
 	ImageObject *m_pImgObjCircImage;
 
+	// Live maps during pullback (a row of the en face map & a column of the L-mode map per frame)
+	np::Uint8Array2 m_visLiveEnFace; // nAlines x LIVE_MAP_FRAMES
+	np::Uint8Array2 m_visLiveLMode; // CIRC_RADIUS x LIVE_MAP_FRAMES (column-wise)
+	np::FloatArray2 m_liveEnFaceDb; // dB values of the maps (scaled again when the contrast is changed)
+	np::FloatArray2 m_liveLModeDb;
+	int m_nLiveFrames;
+	int m_nLiveDrawnFrames;
+	std::atomic<bool> m_bLiveRescale; // contrast changed during acquisition (maps scaled again with the next frame)
+	std::atomic<bool> m_bLiveRedraw; // all the rows & columns are drawn on the next display
+
 	circularize* m_pCirc;
-	medfilt* m_pMedfilt;
+	std::atomic<int> m_circDiameter; // circularized at the viewport resolution
+	display_kernel* m_pDisplayKernel;
 
 private:
     // Layout
@@ -130,6 +174,8 @@ private:
     // Image viewer widgets
     QImageView *m_pImageView_RectImage;
     QImageView *m_pImageView_CircImage;
+	QImageView *m_pImageView_LiveEnFace;
+	QImageView *m_pImageView_LiveLMode;
 
     // OCT visualization option widgets
 	QGroupBox *m_pGroupBox_OctVisualization;
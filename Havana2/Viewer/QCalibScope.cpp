@@ -1,6 +1,8 @@
 
 #include "QCalibScope.h"
 
+#include <algorithm>
+
 
 QCalibScope::QCalibScope(QWidget *parent) :
 	QDialog(parent)
@@ -183,16 +185,18 @@ QRenderAreaCalib::QRenderAreaCalib(QWidget *parent) :
 	memset(m_selected1, 0, sizeof(int) * 2);
 }
 
-void QRenderAreaCalib::paintEvent(QPaintEvent *)
+void QRenderAreaCalib::drawGrid()
 {
-    QPainter painter(this);
-    painter.setRenderHint(QPainter::Antialiasing, true);
+	// Area size
+	int w = this->width();
+	int h = this->height();
 
-    // Area size
-    int w = this->width();
-    int h = this->height();
+	m_grid = QPixmap(w, h);
+	m_grid.fill(QColor(0x282d30));
+
+	QPainter painter(&m_grid);
+	painter.setRenderHint(QPainter::Antialiasing, true);
 
-    // Draw grid
     painter.setPen(QColor(0x4f5555)); // Minor grid color
     for (int i = 0; i <= 64; i++)
         painter.drawLine(i * w / 64, 0, i * w / 64, h);
@@ -201,8 +205,25 @@ void QRenderAreaCalib::paintEvent(QPaintEvent *)
         painter.drawLine(i * w / 8, 0, i * w / 8, h);
     for (int i = 0; i <= 4; i++)
         painter.drawLine(0, i * h / 4, w, i * h / 4);
+}
+
+void QRenderAreaCalib::paintEvent(QPaintEvent *)
+{
+    QPainter painter(this);
+    painter.setRenderHint(QPainter::Antialiasing, true);
+
+    // Area size
+    int w = this->width();
+    int h = this->height();
+	if ((w <= 0) || (h <= 0))
+		return;
+
+    // Draw grid (cached)
+	if (m_grid.size() != size())
+		drawGrid();
+	painter.drawPixmap(0, 0, m_grid);
 	
-    // Draw graph
+    // Draw graph (polylines decimated to the pixel columns)
     if (m_pData != nullptr)
     {
 		int temp;
@@ -215,21 +236,27 @@ void QRenderAreaCalib::paintEvent(QPaintEvent *)
 			m_selected1[0] = temp;
 		}
 
-		for (int i = (int)(m_xRange.min); i < (int)(m_xRange.max - 1); i++)
+		int start = (int)m_xRange.min, end = (int)m_xRange.max;
+		QPolygonF polyline;
+		if (m_bSelectionAvailable)
 		{
-			QPointF x0, x1;
-			x0.setX((float)(i) / (float)m_sizeGraph.width() * w);
-			x0.setY((float)(m_yRange.max - m_pData[i]) * (float)h / (float)(m_yRange.max - m_yRange.min));
-			x1.setX((float)(i + 1) / (float)m_sizeGraph.width() * w);
-			x1.setY((float)(m_yRange.max - m_pData[i + 1]) * (float)h / (float)(m_yRange.max - m_yRange.min));
-
-			if (((i >= m_selected1[0]) && (i <= m_selected1[1])) && m_bSelectionAvailable)
-				painter.setPen(QColor(0xe15dff)); // pink
-			else
-				painter.setPen(QColor(0xfff65d)); // yellow
-            
-			painter.drawLine(x0, x1);			
-        }
+			// Segments before & after the selection (yellow), segments from the selected samples (pink)
+			painter.setPen(QColor(0xfff65d));
+			scopePolyline(m_pData, start, std::min(m_selected1[0] + 1, end), m_sizeGraph.width(), m_yRange, w, h, polyline);
+			painter.drawPolyline(polyline);
+			scopePolyline(m_pData, std::max(m_selected1[1] + 1, start), end, m_sizeGraph.width(), m_yRange, w, h, polyline);
+			painter.drawPolyline(polyline);
+
+			painter.setPen(QColor(0xe15dff));
+			scopePolyline(m_pData, std::max(m_selected1[0], start), std::min(m_selected1[1] + 2, end), m_sizeGraph.width(), m_yRange, w, h, polyline);
+			painter.drawPolyline(polyline);
+		}
+		else
+		{
+			painter.setPen(QColor(0xfff65d)); // yellow
+			scopePolyline(m_pData, start, end, m_sizeGraph.width(), m_yRange, w, h, polyline);
+			painter.drawPolyline(polyline);
+		}
     }
 }
 
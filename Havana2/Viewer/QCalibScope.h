@@ -59,6 +59,9 @@ protected:
 	void mousePressEvent(QMouseEvent *);
 	void mouseMoveEvent(QMouseEvent *);
 	void mouseReleaseEvent(QMouseEvent *);
+
+private:
+	void drawGrid();
 	
 public:
     float* m_pData;
@@ -66,6 +69,7 @@ public:
     QRange m_xRange;
     QRange m_yRange;
     QSizeF m_sizeGraph;
+	QPixmap m_grid; // background & grid (redrawn if the size is changed)
 
 	bool m_bSelectionAvailable;
 	bool m_bMousePressed;
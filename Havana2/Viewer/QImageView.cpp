@@ -3,36 +3,10 @@
 #include "QImageView.h"
 #include <ipps.h>
 
-
-ColorTable::ColorTable()
-{
-	// Color table list	
-	m_cNameVector.push_back("gray");
-	m_cNameVector.push_back("invgray");
-	m_cNameVector.push_back("sepia");
-	m_cNameVector.push_back("jet");
-	m_cNameVector.push_back("parula");
-	m_cNameVector.push_back("hot");
-	m_cNameVector.push_back("fire");
-	// ο  ̸ ߰ ϱ
-
-	for (int i = 0; i < m_cNameVector.size(); i++)
-	{
-		QFile file("ColorTable/" + m_cNameVector.at(i) + ".colortable");
-		file.open(QIODevice::ReadOnly);
-		np::Uint8Array2 rgb(256, 3);
-		file.read(reinterpret_cast<char*>(rgb.raw_ptr()), sizeof(uint8_t) * rgb.length());
-		file.close();
-
-		QVector<QRgb> temp_vector;
-		for (int j = 0; j < 256; j++)
-		{
-			QRgb color = qRgb(rgb(j, 0), rgb(j, 1), rgb(j, 2));
-			temp_vector.push_back(color);
-		}
-		m_colorTableVector.push_back(temp_vector);
-	}
-}
+#include <algorithm>
+#include <cmath>
+#include <tbb/parallel_for.h>
+#include <tbb/blocked_range.h>
 
 
 QImageView::QImageView(QWidget *parent) :
@@ -66,10 +40,11 @@ QImageView::QImageView(ColorTable::colortable ctable, int width, int height, boo
 	{
 		m_pRenderImage->m_pImage = new QImage(m_width, m_height, QImage::Format_Indexed8);
 		m_pRenderImage->m_pImage->setColorCount(256);
-		m_pRenderImage->m_pImage->setColorTable(m_colorTable.m_colorTableVector.at(ctable));
+		m_pRenderImage->m_pImage->setColorTable(ColorTable::instance().m_colorTableVector.at(ctable));
 	}
 	else
 		m_pRenderImage->m_pImage = new QImage(m_width, m_height, QImage::Format_RGB888);
+	m_pRenderImage->m_logicalSize = QSize(m_width, m_height);
 
 	memset(m_pRenderImage->m_pImage->bits(), 0, m_pRenderImage->m_pImage->byteCount());
 
@@ -104,8 +79,25 @@ void QImageView::resetSize(int width, int height)
 	// Set image size
 	m_width = width;
 	m_height = height;	
+	if (m_pRenderImage->m_logicalSize != QSize(m_width, m_height))
+		m_pRenderImage->resetView(); // the zoomed part is not of the new image
+	m_pRenderImage->m_logicalSize = QSize(m_width, m_height);
 
 	// Create QImage object
+	createImage(m_width, m_height);
+}
+
+void QImageView::setDisplaySize(int width, int height)
+{
+	if ((m_pRenderImage->m_pImage->width() == width) && (m_pRenderImage->m_pImage->height() == height))
+		return;
+
+	// Only the image is resized (e.g. rendered at the viewport resolution)
+	createImage(width, height);
+}
+
+void QImageView::createImage(int width, int height)
+{
 	QRgb rgb[256];
 	if (!m_bRgbUsed)
 	{
@@ -118,23 +110,30 @@ void QImageView::resetSize(int width, int height)
 
 	if (!m_bRgbUsed)
 	{
-		m_pRenderImage->m_pImage = new QImage(m_width, m_height, QImage::Format_Indexed8);
+		m_pRenderImage->m_pImage = new QImage(width, height, QImage::Format_Indexed8);
 		m_pRenderImage->m_pImage->setColorCount(256);
 		for (int i = 0; i < 256; i++)
 			m_pRenderImage->m_pImage->setColor(i, rgb[i]);
 	}
 	else
-		m_pRenderImage->m_pImage = new QImage(m_width, m_height, QImage::Format_RGB888);
+		m_pRenderImage->m_pImage = new QImage(width, height, QImage::Format_RGB888);
 
 	memset(m_pRenderImage->m_pImage->bits(), 0, m_pRenderImage->m_pImage->byteCount());
-
+	m_pRenderImage->invalidate();
 }
 
 void QImageView::resetColormap(ColorTable::colortable ctable)
 {
-	m_pRenderImage->m_pImage->setColorTable(m_colorTable.m_colorTableVector.at(ctable));
+	m_pRenderImage->m_pImage->setColorTable(ColorTable::instance().m_colorTableVector.at(ctable));
 
-	m_pRenderImage->update();
+	m_pRenderImage->invalidate();
+}
+
+void QImageView::setColorTable(const QVector<QRgb>& ctable)
+{
+	m_pRenderImage->m_pImage->setColorTable(ctable);
+
+	m_pRenderImage->invalidate();
 }
 
 void QImageView::setHorizontalLine(int len, ...)
@@ -211,26 +210,49 @@ void QImageView::setDoubleClickedMouseCallback(const std::function<void(void)> &
 	m_pRenderImage->DidDoubleClickedMouse += slot;
 }
 
+void QImageView::setResizedCallback(const std::function<void(QSize)> &slot)
+{
+	m_pRenderImage->DidResized.clear();
+	m_pRenderImage->DidResized += slot;
+}
+
 void QImageView::drawImage(uint8_t* pImage)
 {
 	memcpy(m_pRenderImage->m_pImage->bits(), pImage, m_pRenderImage->m_pImage->byteCount());	
-	m_pRenderImage->update();
+	m_pRenderImage->invalidate();
+}
+
+void QImageView::drawImageRow(const uint8_t* pRow, int row)
+{
+	memcpy(m_pRenderImage->m_pImage->scanLine(row), pRow, m_width);
+	m_pRenderImage->invalidate();
+}
+
+void QImageView::drawImageColumn(const uint8_t* pColumn, int col)
+{
+	for (int i = 0; i < m_height; i++)
+		m_pRenderImage->m_pImage->scanLine(i)[col] = pColumn[i];
+	m_pRenderImage->invalidate();
 }
 
 void QImageView::drawRgbImage(uint8_t* pImage)
 {		
 	QImage *pImg = new QImage(pImage, m_width, m_height, QImage::Format_RGB888);
 	m_pRenderImage->m_pImage = std::move(pImg);
-	m_pRenderImage->update();
+	m_pRenderImage->invalidate();
 }
 
 
 
 
 QRenderImage::QRenderImage(QWidget *parent) :
-	QWidget(parent), m_pImage(nullptr), m_colorLine(0xff0000),
+	QWidget(parent), m_pImage(nullptr), m_bCacheValid(false), m_colorLine(0xff0000),
 	m_bMeasureDistance(false), m_nClicked(0),
-	m_hLineLen(0), m_vLineLen(0), m_circLen(0), m_bRadial(false)
+	m_hLineLen(0), m_vLineLen(0), m_circLen(0), m_bRadial(false),
+	m_zoom(1.0), m_center(0.5, 0.5), m_bPanning(false),
+	m_generation(0), m_pyramidGeneration(-1), m_sourceGeneration(-1), m_sourceLevels(0), m_bSourcePending(false),
+	m_lastChange(std::chrono::steady_clock::now()), m_buildTime(0), m_bSettlePending(false),
+	m_bStopPyramid(false)
 {
 	m_pHLineInd = new int[10];
 	m_pVLineInd = new int[10];
@@ -238,6 +260,14 @@ QRenderImage::QRenderImage(QWidget *parent) :
 
 QRenderImage::~QRenderImage()
 {
+	{
+		std::unique_lock<std::mutex> lock(m_mtxPyramid);
+		m_bStopPyramid = true;
+		m_condPyramid.notify_all();
+	}
+	if (m_pyramidWorker.joinable())
+		m_pyramidWorker.join();
+
 	delete m_pHLineInd;
 	delete m_pVLineInd;
 }
@@ -251,26 +281,35 @@ void QRenderImage::paintEvent(QPaintEvent *)
     int w = this->width();
     int h = this->height();
 
-    // Draw image
-    if (m_pImage)
-        painter.drawImage(QRect(0, 0, w, h), *m_pImage);
+    // Draw image (converted & scaled only if the image, the view or the widget size is changed)
+    if (m_pImage && (w > 0) && (h > 0))
+    {
+		if (!m_bCacheValid || (m_cache.size() != size()))
+		{
+			m_cache = QPixmap(w, h);
+			QPainter cache(&m_cache);
+			drawView(cache, w, h);
+			m_bCacheValid = true;
+		}
+		painter.drawPixmap(0, 0, m_cache);
+    }
 
-	// Draw assitive lines
+	// Draw assitive lines (coordinates of the whole image, mapped to the zoomed view)
 	for (int i = 0; i < m_hLineLen; i++)
 	{
-		QPointF p1; p1.setX(0.0);       p1.setY((double)(m_pHLineInd[i] * h) / (double)m_pImage->height());
-		QPointF p2; p2.setX((double)w); p2.setY((double)(m_pHLineInd[i] * h) / (double)m_pImage->height());
+		QPointF p1; p1.setX(0.0);       p1.setY((double)(m_pHLineInd[i] * h) / (double)m_logicalSize.height());
+		QPointF p2; p2.setX((double)w); p2.setY((double)(m_pHLineInd[i] * h) / (double)m_logicalSize.height());
 
 		painter.setPen(m_colorLine);
-		painter.drawLine(p1, p2);
+		painter.drawLine(toView(p1), toView(p2));
 	}
 	for (int i = 0; i < m_vLineLen; i++)
 	{
 		QPointF p1, p2;
 		if (!m_bRadial)
 		{
-			p1.setX((double)(m_pVLineInd[i] * w) / (double)m_pImage->width()); p1.setY(0.0);
-			p2.setX((double)(m_pVLineInd[i] * w) / (double)m_pImage->width()); p2.setY((double)h);
+			p1.setX((double)(m_pVLineInd[i] * w) / (double)m_logicalSize.width()); p1.setY(0.0);
+			p2.setX((double)(m_pVLineInd[i] * w) / (double)m_logicalSize.width()); p2.setY((double)h);
 		}
 		else
 		{			
@@ -281,15 +320,15 @@ void QRenderImage::paintEvent(QPaintEvent *)
 		}
 
 		painter.setPen(m_colorLine);
-		painter.drawLine(p1, p2);
+		painter.drawLine(toView(p1), toView(p2));
 	}
 	for (int i = 0; i < m_circLen; i++)
 	{
 		QPointF center; center.setX(w / 2); center.setY(h / 2);
-		double radius = (double)(m_pHLineInd[i] * h) / (double)m_pImage->height();
+		double radius = (double)(m_pHLineInd[i] * h) / (double)m_logicalSize.height() * m_zoom;
 
 		painter.setPen(m_colorLine);
-		painter.drawEllipse(center, radius, radius);
+		painter.drawEllipse(toView(center), radius, radius);
 	}
 
 	// Measure distance
@@ -302,42 +341,263 @@ void QRenderImage::paintEvent(QPaintEvent *)
 		for (int i = 0; i < m_nClicked; i++)
 		{
 			p[i] = QPointF(m_point[i][0], m_point[i][1]);
-			painter.drawPoint(p[i]);
+			painter.drawPoint(toView(p[i]));
 			
 			if (i == 1)
 			{
 				// Connecting line
 				QPen pen; pen.setColor(Qt::red); pen.setWidth(1);
 				painter.setPen(pen);
-				painter.drawLine(p[0], p[1]);
+				painter.drawLine(toView(p[0]), toView(p[1]));
 				
 				// Euclidean distance
 				double dist = sqrt((p[0].x() - p[1].x()) * (p[0].x() - p[1].x())
-					+ (p[0].y() - p[1].y()) * (p[0].y() - p[1].y())) * (double)m_pImage->height() / (double)this->height();
+					+ (p[0].y() - p[1].y()) * (p[0].y() - p[1].y())) * (double)m_logicalSize.height() / (double)this->height();
 				printf("Measured distance: %.1f\n", dist);
 
 				QFont font; font.setBold(true);
 				painter.setFont(font);
-				painter.drawText((p[0] + p[1]) / 2, QString::number(dist, 'f', 1));
+				painter.drawText(toView((p[0] + p[1]) / 2), QString::number(dist, 'f', 1));
 			}
 		}
 	}
 }
 
+void QRenderImage::drawView(QPainter& painter, int w, int h)
+{
+	// Visible part of the image (full resolution)
+	QRectF view = viewRect();
+	QRectF src(view.x() * m_pImage->width(), view.y() * m_pImage->height(),
+		view.width() * m_pImage->width(), view.height() * m_pImage->height());
+
+	// Smallest pyramid level still with an image pixel per screen pixel at least
+	int level = 0;
+	while ((level < max_levels) && (src.width() / (2 << level) >= w) && (src.height() / (2 << level) >= h))
+		level++;
+
+	if (level > 0)
+	{
+		QImage image;
+		{
+			std::unique_lock<std::mutex> lock(m_mtxPyramid);
+			if ((m_pyramidGeneration == m_generation) && ((int)m_pyramid.size() >= level))
+				image = m_pyramid[level - 1]; // shared (not copied)
+		}
+
+		if (!image.isNull())
+		{
+			double scale = 1.0 / (1 << level);
+			painter.drawImage(QRectF(0, 0, w, h), image, QRectF(src.x() * scale, src.y() * scale, src.width() * scale, src.height() * scale));
+			return;
+		}
+
+		// Not built yet: drawn from the full resolution meanwhile
+		// Built only for an image unchanged for a while (a live image would discard every pyramid before it is used)
+		std::chrono::steady_clock::duration settle;
+		{
+			std::unique_lock<std::mutex> lock(m_mtxPyramid);
+			settle = std::max<std::chrono::steady_clock::duration>(std::chrono::milliseconds((int)pyramid_settle), 2 * m_buildTime);
+		}
+		std::chrono::steady_clock::duration unchanged = std::chrono::steady_clock::now() - m_lastChange;
+		if (unchanged >= settle)
+			requestPyramid(level);
+		else if (!m_bSettlePending)
+		{
+			m_bSettlePending = true;
+			QTimer::singleShot((int)std::chrono::duration_cast<std::chrono::milliseconds>(settle - unchanged).count() + 1, this, SLOT(settlePyramid()));
+		}
+	}
+
+	painter.drawImage(QRectF(0, 0, w, h), *m_pImage, src);
+}
+
+void QRenderImage::invalidate()
+{
+	m_generation++;
+	m_lastChange = std::chrono::steady_clock::now();
+	m_bCacheValid = false;
+	update();
+}
+
+void QRenderImage::resetView()
+{
+	if ((m_zoom == 1.0) && (m_center == QPointF(0.5, 0.5)))
+		return;
+
+	m_zoom = 1.0;
+	m_center = QPointF(0.5, 0.5);
+	m_bPanning = false;
+
+	m_bCacheValid = false;
+	update();
+
+	DidResized(viewResolution());
+}
+
+QSize QRenderImage::viewResolution() const
+{
+	return QSize((int)ceil(width() * m_zoom), (int)ceil(height() * m_zoom));
+}
+
+QRectF QRenderImage::viewRect() const
+{
+	double size = 1.0 / m_zoom;
+	double x = std::min(std::max(m_center.x() - 0.5 * size, 0.0), 1.0 - size);
+	double y = std::min(std::max(m_center.y() - 0.5 * size, 0.0), 1.0 - size);
+
+	return QRectF(x, y, size, size);
+}
+
+QPointF QRenderImage::toView(const QPointF& p) const
+{
+	QRectF view = viewRect();
+	return QPointF((p.x() / width() - view.x()) * m_zoom * width(), (p.y() / height() - view.y()) * m_zoom * height());
+}
+
+QPointF QRenderImage::fromView(const QPointF& p) const
+{
+	QRectF view = viewRect();
+	return QPointF((p.x() / width() / m_zoom + view.x()) * width(), (p.y() / height() / m_zoom + view.y()) * height());
+}
+
+void QRenderImage::requestPyramid(int levels)
+{
+	std::unique_lock<std::mutex> lock(m_mtxPyramid);
+
+	// Already requested for this image
+	if ((m_sourceGeneration == m_generation) && (m_sourceLevels >= levels))
+		return;
+
+	m_pyramidSource = m_pImage->copy(); // the image is overwritten by the next frame
+	m_sourceGeneration = m_generation;
+	m_sourceLevels = levels;
+	m_bSourcePending = true;
+
+	if (!m_pyramidWorker.joinable())
+		m_pyramidWorker = std::thread([&]() { buildPyramid(); });
+	m_condPyramid.notify_all();
+}
+
+template <int C>
+static void reduce2x(const QImage& src, QImage& dst)
+{
+	// 2x2 box average (the last odd row & column are dropped)
+	int width = src.width() / 2, height = src.height() / 2;
+	dst = QImage(width, height, src.format());
+	if (src.format() == QImage::Format_Indexed8)
+		dst.setColorTable(src.colorTable()); // the indices are averaged (monotonic color tables)
+
+	const uchar* pSrc = src.constBits();
+	uchar* pDst = dst.bits();
+	int src_step = src.bytesPerLine(), dst_step = dst.bytesPerLine();
+
+	tbb::parallel_for(tbb::blocked_range<int>(0, height, 16),
+		[&](const tbb::blocked_range<int>& r) {
+		for (int i = r.begin(); i != r.end(); ++i)
+		{
+			const uchar* r0 = pSrc + (2 * i) * src_step;
+			const uchar* r1 = r0 + src_step;
+			uchar* d = pDst + i * dst_step;
+			for (int j = 0; j < width; j++)
+				for (int c = 0; c < C; c++)
+					d[C * j + c] = (uchar)((r0[2 * C * j + c] + r0[2 * C * j + C + c] + r1[2 * C * j + c] + r1[2 * C * j + C + c] + 2) >> 2);
+		}
+	});
+}
+
+void QRenderImage::buildPyramid()
+{
+	while (true)
+	{
+		QImage source;
+		int generation, levels;
+		{
+			std::unique_lock<std::mutex> lock(m_mtxPyramid);
+			m_condPyramid.wait(lock, [&]() { return m_bStopPyramid || m_bSourcePending; });
+			if (m_bStopPyramid)
+				break;
+
+			source = m_pyramidSource;
+			m_pyramidSource = QImage();
+			generation = m_sourceGeneration;
+			levels = m_sourceLevels;
+			m_bSourcePending = false;
+		}
+		std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+		std::vector<QImage> pyramid;
+		pyramid.reserve(levels);
+		for (int k = 0; k < levels; k++)
+		{
+			const QImage& prev = (k == 0) ? source : pyramid[k - 1];
+			if ((prev.width() < 2) || (prev.height() < 2))
+				break;
+
+			QImage next;
+			switch (prev.depth())
+			{
+			case 8: reduce2x<1>(prev, next); break;
+			case 24: reduce2x<3>(prev, next); break;
+			default: reduce2x<4>(prev, next); break;
+			}
+			pyramid.push_back(next);
+		}
+
+		{
+			std::unique_lock<std::mutex> lock(m_mtxPyramid);
+			m_pyramid.swap(pyramid);
+			m_pyramidGeneration = generation;
+			m_buildTime = std::chrono::steady_clock::now() - start;
+		}
+		QMetaObject::invokeMethod(this, "didBuildPyramid", Qt::QueuedConnection);
+	}
+}
+
+void QRenderImage::didBuildPyramid()
+{
+	{
+		std::unique_lock<std::mutex> lock(m_mtxPyramid);
+		if (m_pyramidGeneration != m_generation) // a newer image is being reduced
+			return;
+	}
+
+	m_bCacheValid = false;
+	update();
+}
+
+void QRenderImage::settlePyramid()
+{
+	// Painted again to request the pyramid (a changed image is painted anyway, which restarts the timer)
+	m_bSettlePending = false;
+	if (std::chrono::steady_clock::now() - m_lastChange >= std::chrono::milliseconds((int)pyramid_settle))
+	{
+		m_bCacheValid = false;
+		update();
+	}
+}
+
 void QRenderImage::mousePressEvent(QMouseEvent *e)
 {
-	QPoint p = e->pos();
+	// Pan (middle button drag, the left & right buttons set the guide lines as before)
+	if (e->button() == Qt::MiddleButton)
+	{
+		m_bPanning = true;
+		m_panPos = e->pos();
+		return;
+	}
+
+	QPoint p = fromView(e->pos()).toPoint();
 
 	if (m_hLineLen == 1)
 	{
-		m_pHLineInd[0] = m_pImage->height() - (int)((double)(p.y() * m_pImage->height()) / (double)this->height());
+		m_pHLineInd[0] = m_logicalSize.height() - (int)((double)(p.y() * m_logicalSize.height()) / (double)this->height());
 		DidChangedHLine(m_pHLineInd[0]);
 	}
 	if (m_vLineLen == 1)
 	{
 		if (!m_bRadial)
 		{
-			m_pVLineInd[0] = (int)((double)(p.x() * m_pImage->width()) / (double)this->width());
+			m_pVLineInd[0] = (int)((double)(p.x() * m_logicalSize.width()) / (double)this->width());
 			DidChangedVLine(m_pVLineInd[0]);
 		}
 		else
@@ -360,6 +620,38 @@ void QRenderImage::mousePressEvent(QMouseEvent *e)
 	}
 }
 
+void QRenderImage::mouseReleaseEvent(QMouseEvent *)
+{
+	m_bPanning = false;
+}
+
+void QRenderImage::wheelEvent(QWheelEvent *e)
+{
+	// Zoom about the cursor
+	double zoom = m_zoom * pow(1.25, e->angleDelta().y() / 120.0);
+	zoom = std::min(std::max(zoom, 1.0), (double)max_zoom);
+	if (zoom == m_zoom)
+		return;
+
+	QRectF view = viewRect();
+	QPointF p((double)e->pos().x() / width(), (double)e->pos().y() / height());
+	QPointF anchor(view.x() + p.x() * view.width(), view.y() + p.y() * view.height()); // stays under the cursor
+
+	m_zoom = zoom;
+	m_center = QPointF(anchor.x() + (0.5 - p.x()) / zoom, anchor.y() + (0.5 - p.y()) / zoom);
+	m_center = viewRect().center();
+
+	m_bCacheValid = false;
+	update();
+
+	DidResized(viewResolution());
+}
+
+void QRenderImage::resizeEvent(QResizeEvent *)
+{
+	DidResized(viewResolution());
+}
+
 void QRenderImage::mouseDoubleClickEvent(QMouseEvent *)
 {
 	DidDoubleClickedMouse();
@@ -367,13 +659,28 @@ void QRenderImage::mouseDoubleClickEvent(QMouseEvent *)
 
 void QRenderImage::mouseMoveEvent(QMouseEvent *e)
 {
+	if (m_bPanning)
+	{
+		QPoint d = e->pos() - m_panPos;
+		m_panPos = e->pos();
+
+		m_center -= QPointF((double)d.x() / width() / m_zoom, (double)d.y() / height() / m_zoom);
+		m_center = viewRect().center();
+
+		m_bCacheValid = false;
+		update();
+		return;
+	}
+
 	QPoint p = e->pos();
 
 	if (QRect(0, 0, this->width(), this->height()).contains(p))
 	{
+		QPointF q = fromView(p);
+
 		QPoint p1;
-		p1.setX((int)((double)(p.x() * m_pImage->width()) / (double)this->width()));
-		p1.setY((int)((double)(p.y() * m_pImage->height()) / (double)this->height()));
+		p1.setX((int)((double)(q.x() * m_logicalSize.width()) / (double)this->width()));
+		p1.setY((int)((double)(q.y() * m_logicalSize.height()) / (double)this->height()));
 
 		DidMovedMouse(p1);
 	}
@@ -9,20 +9,16 @@
 
 #include <stdarg.h>
 
+#include <vector>
+#include <chrono>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
 #include <Common/array.h>
 #include <Common/callback.h>
-using ColorTableVector = QVector<QVector<QRgb>>;
+#include <Common/ColorTable.h>
 
-class ColorTable
-{
-public:
-	explicit ColorTable();
-
-public:
-	enum colortable { gray = 0, inv_gray, sepia, jet, parula, hot, fire }; //   colortable ̸ ߰ϱ
-	QVector<QString> m_cNameVector;
-	ColorTableVector m_colorTableVector;
-};
 class QRenderImage;
 
 
@@ -45,7 +41,9 @@ protected:
 
 public:
 	void resetSize(int width, int height);
+	void setDisplaySize(int width, int height); // image resolution (the coordinates are still of resetSize)
     void resetColormap(ColorTable::colortable ctable);
+	void setColorTable(const QVector<QRgb>& ctable);
 	void setSquare(bool square) { m_bSquareConstraint = square; }
 #ifdef OCT_FLIM
     void setRgbEnable(bool rgb) { m_bRgbUsed = rgb; }
@@ -63,15 +61,22 @@ public:
 public:
 	void setMovedMouseCallback(const std::function<void(QPoint&)> &slot);
 	void setDoubleClickedMouseCallback(const std::function<void(void)> &slot);
+	void setResizedCallback(const std::function<void(QSize)> &slot);
 
 public slots:
 	void drawImage(uint8_t* pImage);
 	void drawRgbImage(uint8_t* pImage);
 
+public: // partial update (only the row or column is copied)
+	void drawImageRow(const uint8_t* pRow, int row); // the whole view is scaled again on the next paint
+	void drawImageColumn(const uint8_t* pColumn, int col);
+
+private:
+	void createImage(int width, int height);
+
 private:
     QHBoxLayout *m_pHBoxLayout;
 
-	ColorTable m_colorTable;
     QRenderImage *m_pRenderImage;
 
 private:
@@ -87,6 +92,11 @@ class QRenderImage : public QWidget
 {
     Q_OBJECT
 
+private:
+	static const int max_levels = 6; // mipmap pyramid levels (1/2 ... 1/64)
+	static const int max_zoom = 16;
+	static const int pyramid_settle = 200; // msec, the image is unchanged at least for this (or a build time) before building
+
 public:
     explicit QRenderImage(QWidget *parent = 0);
 	virtual ~QRenderImage();
@@ -96,9 +106,32 @@ protected:
 	void mousePressEvent(QMouseEvent *);
 	void mouseDoubleClickEvent(QMouseEvent *);
 	void mouseMoveEvent(QMouseEvent *);
+	void mouseReleaseEvent(QMouseEvent *);
+	void wheelEvent(QWheelEvent *);
+	void resizeEvent(QResizeEvent *);
+
+public:
+	void invalidate(); // the image is changed (converted & scaled again on the next paint)
+	void resetView(); // whole image fitted to the widget (zoom 1)
+	QSize viewResolution() const; // widget size x zoom (image resolution worth rendering)
+
+private:
+	QRectF viewRect() const; // visible part of the image (normalized)
+	QPointF toView(const QPointF& p) const; // from the coordinates of the whole image fitted to the widget
+	QPointF fromView(const QPointF& p) const;
+	void drawView(QPainter& painter, int w, int h);
+	void requestPyramid(int levels);
+	void buildPyramid();
+
+private slots:
+	void didBuildPyramid();
+	void settlePyramid();
 
 public:
     QImage *m_pImage;
+	QPixmap m_cache; // image converted & scaled to the widget (overlays are painted on top of it)
+	bool m_bCacheValid;
+	QSize m_logicalSize; // size of the coordinates (might be different from the image)
 
     int *m_pHLineInd, *m_pVLineInd;
     int m_hLineLen, m_vLineLen;
@@ -116,6 +149,34 @@ public:
 	callback<int> DidChangedRLine;
 	callback<void> DidDoubleClickedMouse;
 	callback<QPoint&> DidMovedMouse;
+	callback<QSize> DidResized;
+
+public:
+	// Zoom & pan (zoom 1: the whole image fitted to the widget)
+	double m_zoom;
+	QPointF m_center; // center of the view (normalized image coordinates)
+
+private:
+	bool m_bPanning;
+	QPoint m_panPos;
+
+	// Mipmap pyramid of the current image (level k: 1/2^k, built in a worker thread)
+	int m_generation; // incremented when the image is changed
+	std::vector<QImage> m_pyramid; // levels 1, 2, ...
+	int m_pyramidGeneration;
+
+	QImage m_pyramidSource; // copy of the image to be reduced (only the newest one is kept)
+	int m_sourceGeneration, m_sourceLevels;
+	bool m_bSourcePending;
+
+	std::chrono::steady_clock::time_point m_lastChange; // of the image (live images are not reduced)
+	std::chrono::steady_clock::duration m_buildTime; // of the last pyramid
+	bool m_bSettlePending;
+
+	std::thread m_pyramidWorker;
+	std::mutex m_mtxPyramid;
+	std::condition_variable m_condPyramid;
+	bool m_bStopPyramid;
 };
 
 
@@ -1,6 +1,11 @@
 
 #include "QScope.h"
 
+#include <ipps.h>
+
+#include <algorithm>
+#include <cmath>
+
 QScope::QScope(QWidget *parent) :
 	QDialog(parent)
 {
@@ -240,6 +245,7 @@ void QRenderArea::setSize(QRange xRange, QRange yRange)
 		memset(m_pMask, 0, sizeof(float) * (int)m_sizeGraph.width());
 	}
 
+	m_grid = QPixmap(); // zero line
 	this->update();
 }
 
@@ -249,18 +255,23 @@ void QRenderArea::setGrid(int nHMajorGrid, int nHMinorGrid, int nVMajorGrid, boo
 	m_nHMinorGrid = nHMinorGrid;
 	m_nVMajorGrid = nVMajorGrid;
 	m_bZeroLine = zeroLine;
+
+	m_grid = QPixmap();
+	this->update();
 }
 
-void QRenderArea::paintEvent(QPaintEvent *)
+void QRenderArea::drawGrid()
 {
-    QPainter painter(this);
-    painter.setRenderHint(QPainter::Antialiasing, true);
+	// Area size
+	int w = this->width();
+	int h = this->height();
 
-    // Area size
-    int w = this->width();
-    int h = this->height();
+	m_grid = QPixmap(w, h);
+	m_grid.fill(QColor(0x282d30));
+
+	QPainter painter(&m_grid);
+	painter.setRenderHint(QPainter::Antialiasing, true);
 
-    // Draw grid
     painter.setPen(QColor(0x4f5555)); // Minor grid color (horizontal)
     for (int i = 0; i <= m_nHMinorGrid; i++)
         painter.drawLine(i * w / m_nHMinorGrid, 0, i * w / m_nHMinorGrid, h);
@@ -273,54 +284,61 @@ void QRenderArea::paintEvent(QPaintEvent *)
 
 	if (m_bZeroLine) // zero line
 		painter.drawLine(0, (m_yRange.max / (m_yRange.max - m_yRange.min)) * h, w, (m_yRange.max / (m_yRange.max - m_yRange.min)) * h);
+}
+
+void QRenderArea::paintEvent(QPaintEvent *)
+{
+    QPainter painter(this);
+    painter.setRenderHint(QPainter::Antialiasing, true);
+
+    // Area size
+    int w = this->width();
+    int h = this->height();
+	if ((w <= 0) || (h <= 0))
+		return;
+
+    // Draw grid (cached)
+	if (m_grid.size() != size())
+		drawGrid();
+	painter.drawPixmap(0, 0, m_grid);
 	
-    // Draw graph
+    // Draw graph (a polyline decimated to the pixel columns)
+	int start = (int)m_xRange.min, end = (int)m_xRange.max;
+	QPolygonF polyline;
     if (m_pData != nullptr)
     {        
 		painter.setPen(QColor(0xfff65d)); // data graph (yellow)
-		for (int i = (int)(m_xRange.min); i < (int)(m_xRange.max - 1); i++)
-		{			
-			QPointF x0, x1;						
-			x0.setX((float)(i) / (float)m_sizeGraph.width() * w);
-            x0.setY((float)(m_yRange.max - m_pData[i    ]) * (float)h / (float)(m_yRange.max - m_yRange.min));
-            x1.setX((float)(i + 1) / (float)m_sizeGraph.width() * w);
-            x1.setY((float)(m_yRange.max - m_pData[i + 1]) * (float)h / (float)(m_yRange.max - m_yRange.min));			
-
-			painter.drawLine(x0, x1);			
-        }
+		scopePolyline(m_pData, start, end, m_sizeGraph.width(), m_yRange, w, h, polyline);
+		painter.drawPolyline(polyline);
     }
 	
-	if (m_bMaskUse && (m_pMask != nullptr))
+	if (m_bMaskUse && (m_pData != nullptr) && (m_pMask != nullptr))
 	{
 		painter.setPen(QColor(0xff0080)); // mask region (hot pink)
-		for (int i = (int)(m_xRange.min); i < (int)(m_xRange.max - 1); i++)
+		for (int i = start; i < end - 1; )
 		{
-			if (m_pMask[i] == 0)
+			if (m_pMask[i] != 0)
 			{
-				QPointF x0, x1;
-				x0.setX((float)(i) / (float)m_sizeGraph.width() * w);
-				x0.setY((float)(m_yRange.max - m_pData[i]) * (float)h / (float)(m_yRange.max - m_yRange.min));
-				x1.setX((float)(i + 1) / (float)m_sizeGraph.width() * w);
-				x1.setY((float)(m_yRange.max - m_pData[i + 1]) * (float)h / (float)(m_yRange.max - m_yRange.min));
-
-				painter.drawLine(x0, x1);
+				i++;
+				continue;
 			}
+
+			// Run of the masked samples
+			int j = i;
+			while ((j < end - 1) && (m_pMask[j] == 0))
+				j++;
+
+			scopePolyline(m_pData, i, j + 1, m_sizeGraph.width(), m_yRange, w, h, polyline);
+			painter.drawPolyline(polyline);
+			i = j;
 		}
 	}	
-	if (m_bSelectionAvailable)
+	if (m_bSelectionAvailable && (m_pData != nullptr))
 	{
 		QPen pen(QColor(0xff6666)); pen.setWidth(3); // selected region (light pink)					
 		painter.setPen(pen);
-		for (int i = m_start; i < m_end; i++)
-		{			
-			QPointF x0, x1;
-			x0.setX((float)(i) / (float)m_sizeGraph.width() * w);
-			x0.setY((float)(m_yRange.max - m_pData[i]) * (float)h / (float)(m_yRange.max - m_yRange.min));
-			x1.setX((float)(i + 1) / (float)m_sizeGraph.width() * w);
-			x1.setY((float)(m_yRange.max - m_pData[i + 1]) * (float)h / (float)(m_yRange.max - m_yRange.min));
-
-			painter.drawLine(x0, x1);	
-		}
+		scopePolyline(m_pData, std::max(m_start, start), std::min(m_end + 1, end), m_sizeGraph.width(), m_yRange, w, h, polyline);
+		painter.drawPolyline(polyline);
 	}
 
 
@@ -418,4 +436,43 @@ void QRenderArea::mouseReleaseEvent(QMouseEvent *e)
 			this->update();
 		}
 	}
-}
\ No newline at end of file
+}
+
+
+void scopePolyline(const float* pData, int start, int end, double nSamples, const QRange& yRange, int w, int h, QPolygonF& polyline)
+{
+	polyline.clear();
+	if ((end - start < 2) || (w <= 0))
+		return;
+
+	double sx = (double)w / nSamples;
+	double sy = (double)h / (yRange.max - yRange.min);
+	auto point = [&](int i) { return QPointF(i * sx, (yRange.max - pData[i]) * sy); };
+
+	if (end - start <= 2 * w)
+	{
+		// Every sample
+		polyline.reserve(end - start);
+		for (int i = start; i < end; i++)
+			polyline << point(i);
+		return;
+	}
+
+	// Min/max envelope of each pixel column
+	polyline.reserve(2 * w + 2);
+	for (int i0 = start; i0 < end; )
+	{
+		int col = (int)(i0 * sx);
+		int i1 = std::min(std::max((int)ceil((col + 1) / sx), i0 + 1), end);
+
+		Ipp32f vmin, vmax;
+		int imin, imax;
+		ippsMinMaxIndx_32f(pData + i0, i1 - i0, &vmin, &imin, &vmax, &imax);
+
+		polyline << point(i0 + std::min(imin, imax));
+		if (imin != imax)
+			polyline << point(i0 + std::max(imin, imax));
+
+		i0 = i1;
+	}
+}
@@ -12,6 +12,9 @@ struct QRange {
     double max;
 };
 
+// Points of the samples [start, end) in a graph of w x h pixels (min & max of each pixel column)
+void scopePolyline(const float* pData, int start, int end, double nSamples, const QRange& yRange, int w, int h, QPolygonF& polyline);
+
 class QRenderArea;
 
 class QScope : public QDialog
@@ -79,6 +82,9 @@ public:
 	void setSize(QRange xRange, QRange yRange);
 	void setGrid(int nHMajorGrid, int nHMinorGrid, int nVMajorGrid, bool zeroLine = false);
 
+private:
+	void drawGrid();
+
 public:
     float* m_pData;
 	float* m_pMask;
@@ -98,6 +104,7 @@ public:
 	int m_nVMajorGrid;
 
 	bool m_bZeroLine;
+	QPixmap m_grid; // background & grid (redrawn if the size or the grid is changed)
 
 	bool m_bSelectionAvailable;
 	bool m_bMousePressed;
@@ -0,0 +1,215 @@
+
+#include "BatchProcessor.h"
+
+#include <QFile>
+#include <QFileInfo>
+#include <QDir>
+
+#include <chrono>
+#include <algorithm>
+
+#include <ipps.h>
+#include <ippi.h>
+
+#include <Common/array.h>
+#include <Common/circularize.h>
+#include <Common/display_kernel.h>
+#include <Common/ImageObject.h>
+
+#include <DataProcess/OCTProcess/OCTProcess.h>
+#include <DataProcess/EnFaceProjection/EnFaceProjection.h>
+#include <MemoryBuffer/OctDataFile.h>
+#include <MemoryBuffer/OctVolume.h>
+#include <MemoryBuffer/MappedRawFile.h>
+
+
+BatchProcessor::BatchProcessor(const BatchOptions& options) :
+	m_options(options), m_colorTable(options.colorTablePath)
+{
+}
+
+BatchProcessor::~BatchProcessor()
+{
+}
+
+
+bool BatchProcessor::process(const QString& fileName)
+{
+	std::chrono::system_clock::time_point start = std::chrono::system_clock::now();
+
+	QByteArray temp = fileName.toLocal8Bit();
+	const char* name = temp.constData();
+
+	QFileInfo fileInfo(fileName);
+	QString fileTitle = fileInfo.path() + "/" + fileInfo.completeBaseName();
+	bool container = (fileInfo.suffix().compare("hvd", Qt::CaseInsensitive) == 0)
+		|| (fileInfo.suffix().compare("cdata", Qt::CaseInsensitive) == 0); // *.cdata: read by the container
+
+	// Read Ini File & Initialization ///////////////////////////////////////////////////////////
+	Configuration config;
+	OctDataFile dataFile;
+	QFile file(fileName);
+	if (container)
+	{
+		if (!dataFile.open(fileName))
+		{
+			printf("[ERROR] Invalid external data! (%s)\n", name);
+			return false;
+		}
+
+		// Configuration snapshot & frame size embedded in the container
+		dataFile.getConfiguration(config);
+	}
+	else
+	{
+		if (!QFile::exists(fileTitle + ".ini") || !file.open(QFile::ReadOnly))
+		{
+			printf("[ERROR] Invalid external data or no configuration file! (%s)\n", name);
+			return false;
+		}
+
+		config.getConfigFile(fileTitle + ".ini");
+		if (m_options.nAlines > 0)
+		{
+			config.nAlines = m_options.nAlines;
+			config.nAlines4 = ((config.nAlines + 3) >> 2) << 2;
+			config.nFrameSize = config.nScans * config.nAlines;
+		}
+		config.nFrames = (int)(file.size() / (qint64)config.nScans / (qint64)config.nAlines / sizeof(uint16_t));
+	}
+	if (m_options.discomVal != INT_MIN) config.octDiscomVal = m_options.discomVal;
+	if (m_options.colorTable >= 0) config.octColorTable = m_options.colorTable;
+	config.octColorTable = std::min(std::max(config.octColorTable, 0), m_colorTable.m_colorTableVector.size() - 1);
+
+	if ((config.nFrames == 0) || (config.nScans == 0) || (config.nAlines == 0))
+	{
+		printf("[ERROR] Empty data! (%s)\n", name);
+		return false;
+	}
+
+	// Set OCT Object ///////////////////////////////////////////////////////////////////////////
+	OCTProcess oct(config.nScans, config.nAlines);
+	if (container)
+		oct.loadCalibrationData(dataFile.section(OCT_SECTION_CALIBRATION), dataFile.section(OCT_SECTION_BACKGROUND));
+	else
+		oct.loadCalibration(fileTitle + ".calibration", fileTitle + ".background");
+	oct.changeDiscomValue(config.octDiscomVal);
+
+	// Raw data reader (memory-mapped if possible) //////////////////////////////////////////////
+	MappedRawFile mappedFile;
+	bool mapped = !container && mappedFile.open(fileName, config.nFrameSize);
+	np::Uint16Array2 fringe(config.nScans, config.nAlines);
+
+	// Output directories ///////////////////////////////////////////////////////////////////////
+	QString folderName = QDir(fileInfo.absolutePath()).dirName();
+	QString path = m_options.outputPath.isEmpty() ? fileInfo.absolutePath() : m_options.outputPath + "/" + folderName;
+
+	QString rectPath = path + "/rect_image/";
+	QString circPath = path + "/circ_image/";
+	QString enFacePath = path + "/en_face/";
+	if (m_options.bRect) QDir().mkpath(rectPath);
+	if (m_options.bCirc) QDir().mkpath(circPath);
+	if (m_options.bEnFace) QDir().mkpath(enFacePath);
+
+	// Processing & visualization buffers ///////////////////////////////////////////////////////
+	const QVector<QRgb>& ctable = m_colorTable.m_colorTableVector.at(config.octColorTable);
+
+	OctVolume::Frame octImage(config.n2ScansFFT, config.nAlines4);
+	memset(octImage.raw_ptr(), 0, sizeof(OctVolume::value_type) * octImage.length());
+	np::FloatArray2 octImageDb(config.n2ScansFFT, config.nAlines4); // for the display kernel
+
+	EnFaceProjection enFace;
+	if (m_options.bEnFace)
+		enFace.allocate(config.nAlines4, config.nFrames, config.circShift);
+
+	ImageObject rectImage(config.nAlines4, config.n2ScansFFT, ctable);
+	ImageObject circImage(2 * CIRC_RADIUS, 2 * CIRC_RADIUS, ctable);
+
+	display_kernel rectKernel(config.n2ScansFFT, config.nAlines4);
+	circularize circ(CIRC_RADIUS, config.nAlines, false);
+
+	printf("Start batch processing... %s (Total nFrame: %d)\n", name, config.nFrames);
+
+	int frameCount;
+	for (frameCount = 0; frameCount < config.nFrames; frameCount++)
+	{
+		// 1. Get raw data
+		const uint16_t* fringe_data = nullptr;
+		if (mapped)
+			fringe_data = mappedFile.frame(frameCount);
+		else if (container ? dataFile.readFrame(frameCount, fringe.raw_ptr())
+			: (file.read(reinterpret_cast<char*>(fringe.raw_ptr()), sizeof(uint16_t) * config.nFrameSize) == (qint64)(sizeof(uint16_t) * config.nFrameSize)))
+			fringe_data = fringe.raw_ptr();
+
+		if (fringe_data == nullptr)
+		{
+			printf("[ERROR] Failed to read frame %d. (%s)\n", frameCount + 1, name);
+			break;
+		}
+
+		// 2. OCT process
+		oct(octImage.raw_ptr(), fringe_data);
+		if (mapped) mappedFile.release(frameCount);
+
+		// 3. En face statistics
+		if (m_options.bEnFace)
+			enFace.processFrame(octImage, frameCount);
+
+		// 4. Cross-sections
+		if (m_options.bRect || m_options.bCirc)
+		{
+			// Scaling, transpose & median filtering in a pass
+			OctVolume::toDb(octImage.raw_ptr(), octImageDb.raw_ptr(), octImageDb.length());
+			rectKernel(octImageDb.raw_ptr(), rectImage.arr.raw_ptr(), (float)config.octDbRange.min, (float)config.octDbRange.max);
+
+			if (m_options.bRect)
+				rectImage.qindeximg.save(rectPath + QString("rect_%1_%2.bmp").arg(folderName).arg(frameCount + 1, 3, 10, (QChar)'0'), "bmp");
+
+			if (m_options.bCirc)
+			{
+				np::Uint8Array2 rect_temp(rectImage.qindeximg.bits(), rectImage.arr.size(0), rectImage.arr.size(1));
+				circ(rect_temp, circImage.qindeximg.bits(), "vertical", config.circShift);
+				circImage.qindeximg.save(circPath + QString("circ_%1_%2.bmp").arg(folderName).arg(frameCount + 1, 3, 10, (QChar)'0'), "bmp");
+			}
+		}
+	}
+	mappedFile.close();
+
+	// En face map writing (every statistic, named as the maps saved by Havana2) ///////////////
+	if (m_options.bEnFace && (frameCount == config.nFrames))
+	{
+		for (int i = 0; i < EnFaceProjection::nStatistics; i++)
+		{
+			EnFaceProjection::statistic stat = (EnFaceProjection::statistic)i;
+			np::FloatArray2& octProjection = enFace.projection(stat);
+			QString projName = enFacePath + "oct_" + EnFaceProjection::name(stat) + "_projection";
+
+			QFile fileOctProj(projName + ".enface");
+			if (false != fileOctProj.open(QIODevice::WriteOnly))
+			{
+				fileOctProj.write(reinterpret_cast<char*>(octProjection.raw_ptr()), sizeof(float) * octProjection.length());
+				fileOctProj.close();
+			}
+
+			// Standard deviation: [0, PROJECTION_STDEV_RANGE]
+			Range<int> range = config.octDbRange;
+			if (stat == EnFaceProjection::stdev)
+			{
+				range.min = 0;
+				range.max = PROJECTION_STDEV_RANGE;
+			}
+
+			IppiSize roi_proj = { octProjection.size(0), octProjection.size(1) };
+			ImageObject imgObjOctProj(roi_proj.width, roi_proj.height, ctable);
+
+			ippiScale_32f8u_C1R(octProjection, sizeof(float) * roi_proj.width, imgObjOctProj.arr.raw_ptr(), sizeof(uint8_t) * roi_proj.width, roi_proj, range.min, range.max);
+			ippiMirror_8u_C1IR(imgObjOctProj.arr.raw_ptr(), sizeof(uint8_t) * roi_proj.width, roi_proj, ippAxsHorizontal);
+			imgObjOctProj.qindeximg.save(projName + ".bmp", "bmp");
+		}
+	}
+
+	std::chrono::duration<double> elapsed = std::chrono::system_clock::now() - start;
+	printf("Batch processing is finished. %s (%d / %d frames, %.2f sec)\n", name, frameCount, config.nFrames, elapsed.count());
+
+	return frameCount == config.nFrames;
+}
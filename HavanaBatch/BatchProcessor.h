@@ -0,0 +1,45 @@
+#ifndef BATCHPROCESSOR_H
+#define BATCHPROCESSOR_H
+
+#include <QString>
+#include <QStringList>
+
+#include <iostream>
+#include <climits>
+
+#include <Havana2/Configuration.h>
+
+#include <Common/ColorTable.h>
+
+// Options of the batch processing
+struct BatchOptions
+{
+	QString outputPath = ""; // Results are written next to the data if empty
+	QString colorTablePath = "ColorTable/";
+
+	int nAlines = 0; // User-defined A-lines of *.data (0: from the ini file)
+	int discomVal = INT_MIN; // INT_MIN: from the ini file
+	int colorTable = -1; // -1: from the ini file
+
+	bool bRect = true;
+	bool bCirc = true;
+	bool bEnFace = true;
+};
+
+// Headless processing of a raw data file in a single pass (can be called for different files concurrently)
+
+class BatchProcessor
+{
+public:
+	explicit BatchProcessor(const BatchOptions& options);
+	virtual ~BatchProcessor();
+
+public:
+	bool process(const QString& fileName);
+
+private:
+	const BatchOptions m_options;
+	ColorTable m_colorTable;
+};
+
+#endif // BATCHPROCESSOR_H
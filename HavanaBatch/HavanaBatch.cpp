@@ -0,0 +1,86 @@
+
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QStringList>
+
+#include <iostream>
+#include <atomic>
+#include <chrono>
+
+#include <tbb/global_control.h>
+#include <tbb/task_arena.h>
+#include <tbb/parallel_for.h>
+#include <tbb/blocked_range.h>
+
+#include "BatchProcessor.h"
+
+
+int main(int argc, char *argv[])
+{
+	QCoreApplication a(argc, argv);
+	QCoreApplication::setApplicationName("HavanaBatch");
+	QCoreApplication::setApplicationVersion(VERSION);
+
+	// Command line options /////////////////////////////////////////////////////////////////////
+	QCommandLineParser parser;
+	parser.setApplicationDescription("Headless batch processor of Havana2 raw data.\n"
+		"*.data & *.cdata files require the sidecar files (*.ini, *.calibration, *.background) with the same name.");
+	parser.addHelpOption();
+	parser.addVersionOption();
+	parser.addPositionalArgument("files", "Raw data files (*.data, *.hvd, *.cdata) to process.", "<files...>");
+
+	QCommandLineOption threadsOption(QStringList() << "j" << "threads", "Thread budget for the whole batch (default: all cores).", "n");
+	QCommandLineOption outputOption(QStringList() << "o" << "output", "Output directory (default: next to each data file).", "dir");
+	QCommandLineOption rectOption("rect", "Write rectangular cross-sections.");
+	QCommandLineOption circOption("circ", "Write circularized cross-sections.");
+	QCommandLineOption enFaceOption("enface", "Write en face maps.");
+	QCommandLineOption alinesOption("alines", "User-defined number of A-lines of *.data files.", "n");
+	QCommandLineOption discomOption("discom", "Dispersion compensation value (default: from the configuration).", "value");
+	QCommandLineOption colorTableOption("colortable", "OCT color table index (default: from the configuration).", "index");
+	QCommandLineOption colorTablePathOption("colortable-path", "Directory of the color table files.", "dir", "ColorTable/");
+	parser.addOptions({ threadsOption, outputOption, rectOption, circOption, enFaceOption,
+		alinesOption, discomOption, colorTableOption, colorTablePathOption });
+
+	parser.process(a);
+
+	QStringList files = parser.positionalArguments();
+	if (files.isEmpty())
+		parser.showHelp(1);
+
+	BatchOptions options;
+	options.outputPath = parser.value(outputOption);
+	options.colorTablePath = parser.value(colorTablePathOption);
+	if (!options.colorTablePath.endsWith("/")) options.colorTablePath += "/";
+	if (parser.isSet(alinesOption)) options.nAlines = parser.value(alinesOption).toInt();
+	if (parser.isSet(discomOption)) options.discomVal = parser.value(discomOption).toInt();
+	if (parser.isSet(colorTableOption)) options.colorTable = parser.value(colorTableOption).toInt();
+	if (parser.isSet(rectOption) || parser.isSet(circOption) || parser.isSet(enFaceOption)) // All outputs if none is specified
+	{
+		options.bRect = parser.isSet(rectOption);
+		options.bCirc = parser.isSet(circOption);
+		options.bEnFace = parser.isSet(enFaceOption);
+	}
+
+	// Thread budget ////////////////////////////////////////////////////////////////////////////
+	int nThreads = parser.isSet(threadsOption) ? parser.value(threadsOption).toInt() : 0;
+	if (nThreads <= 0) nThreads = tbb::this_task_arena::max_concurrency();
+	tbb::global_control control(tbb::global_control::max_allowed_parallelism, nThreads);
+
+	// Batch processing (files in parallel, frames in parallel over A-lines) ////////////////////
+	std::chrono::system_clock::time_point start = std::chrono::system_clock::now();
+
+	BatchProcessor processor(options);
+	std::atomic<int> nFailed(0);
+
+	tbb::parallel_for(tbb::blocked_range<int>(0, files.size(), 1),
+		[&](const tbb::blocked_range<int>& r) {
+		for (int i = r.begin(); i != r.end(); ++i)
+			if (!processor.process(files.at(i)))
+				nFailed++;
+	});
+
+	std::chrono::duration<double> elapsed = std::chrono::system_clock::now() - start;
+	printf("\nBatch processing is finished. (%d / %d files, elapsed time : %.2f sec)\n", files.size() - (int)nFailed, files.size(), elapsed.count());
+
+	return (nFailed == 0) ? 0 : 1;
+}
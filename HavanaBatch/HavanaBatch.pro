@@ -0,0 +1,86 @@
+#-------------------------------------------------
+#
+# Headless batch processor of Havana2 raw data
+# (links the processing core only, no widgets & devices)
+#
+#-------------------------------------------------
+
+QT       += core gui
+QT       -= widgets
+
+TARGET = HavanaBatch
+TEMPLATE = app
+
+CONFIG += console c++11
+CONFIG -= app_bundle
+
+DEFINES += QT_DEPRECATED_WARNINGS
+
+INCLUDEPATH += $$PWD/..
+
+
+macx {
+    INCLUDEPATH += /opt/intel/ipp/include \
+                /opt/intel/tbb/include \
+                /opt/intel/mkl/include
+
+    IPPLIBS = -lippch -lippcore -lippi -lipps -lippvm
+    MKLLIBS = -lmkl_core -lmkl_tbb_thread -lmkl_intel_lp64
+
+    LIBS += -L/opt/intel/ipp/lib $$IPPLIBS
+    LIBS += -L/opt/intel/tbb/lib -ltbb
+    LIBS += -L/opt/intel/mkl/lib $$MKLLIBS
+}
+unix:!macx {
+    INCLUDEPATH += /opt/intel/ipp/include \
+                /opt/intel/tbb/include \
+                /opt/intel/mkl/include
+
+    IPPLIBS = -lippch -lippcore -lippi -lipps -lippvm
+    MKLLIBS = -lmkl_core -lmkl_tbb_thread -lmkl_intel_lp64
+
+    LIBS += -L/opt/intel/ipp/lib/intel64 $$IPPLIBS
+    LIBS += -L/opt/intel/tbb/lib/intel64/gcc4.7 -ltbb
+    LIBS += -L/opt/intel/mkl/lib/intel64 $$MKLLIBS
+}
+win32 {
+    INCLUDEPATH += $$PWD/../include
+
+    LIBS += $$PWD/../lib/intel64_win/ippch.lib \
+            $$PWD/../lib/intel64_win/ippcc.lib \
+            $$PWD/../lib/intel64_win/ippcore.lib \
+            $$PWD/../lib/intel64_win/ippi.lib \
+            $$PWD/../lib/intel64_win/ipps.lib \
+            $$PWD/../lib/intel64_win/ippvm.lib
+    debug {
+        LIBS += $$PWD/../lib/intel64_win/vc14/tbb_debug.lib
+    }
+    release {
+        LIBS += $$PWD/../lib/intel64_win/vc14/tbb.lib
+    }
+    LIBS += $$PWD/../lib/intel64_win/mkl_core.lib \
+            $$PWD/../lib/intel64_win/mkl_tbb_thread.lib \
+            $$PWD/../lib/intel64_win/mkl_intel_lp64.lib
+}
+
+
+SOURCES += HavanaBatch.cpp \
+    BatchProcessor.cpp
+
+SOURCES += ../DataProcess/OCTProcess/OCTProcess.cpp \
+    ../DataProcess/EnFaceProjection/EnFaceProjection.cpp
+
+SOURCES += ../MemoryBuffer/OctDataFile.cpp \
+    ../MemoryBuffer/MappedRawFile.cpp \
+    ../MemoryBuffer/OctVolume.cpp
+
+
+HEADERS += BatchProcessor.h \
+    ../Havana2/Configuration.h
+
+HEADERS += ../DataProcess/OCTProcess/OCTProcess.h \
+    ../DataProcess/EnFaceProjection/EnFaceProjection.h
+
+HEADERS += ../MemoryBuffer/OctDataFile.h \
+    ../MemoryBuffer/MappedRawFile.h \
+    ../MemoryBuffer/OctVolume.h
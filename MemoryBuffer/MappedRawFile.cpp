@@ -0,0 +1,182 @@
+
+#include "MappedRawFile.h"
+
+#if !defined(_WIN32)
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+#define PAGE_SIZE_TOUCH		4096
+
+
+MappedRawFile::MappedRawFile(int windowFrames, int prefetchFrames) :
+	m_windowFrames(windowFrames), m_prefetchFrames(std::min(prefetchFrames, windowFrames)),
+	m_frameBytes(0), m_nFrames(0),
+	m_prefetchTarget(0), m_prefetched(0), m_bRunning(false)
+{
+}
+
+MappedRawFile::~MappedRawFile()
+{
+	close();
+}
+
+
+bool MappedRawFile::open(const QString& path, int frameSize)
+{
+	close();
+
+	m_file.setFileName(path);
+	if (!m_file.open(QIODevice::ReadOnly))
+		return false;
+
+	m_frameBytes = (qint64)(sizeof(uint16_t) * frameSize);
+	m_nFrames = (int)(m_file.size() / m_frameBytes);
+
+	// Map the first window to check if the file can be mapped
+	{
+		std::unique_lock<std::mutex> lock(m_mtx);
+		if ((m_nFrames == 0) || !window(0))
+		{
+			m_file.close();
+			m_nFrames = 0;
+			return false;
+		}
+	}
+
+	// Start prefetch thread
+	if (m_prefetchFrames > 0)
+	{
+		m_prefetchTarget = 0;
+		m_prefetched = 0;
+		m_bRunning = true;
+		m_prefetchThread = std::thread(&MappedRawFile::prefetch, this);
+	}
+
+	return true;
+}
+
+void MappedRawFile::close()
+{
+	if (m_prefetchThread.joinable())
+	{
+		{
+			std::unique_lock<std::mutex> lock(m_mtx);
+			m_bRunning = false;
+		}
+		m_cv.notify_one();
+		m_prefetchThread.join();
+	}
+
+	for (auto& w : m_windows)
+		m_file.unmap(w.second.ptr);
+	m_windows.clear();
+
+	if (m_file.isOpen())
+		m_file.close();
+	m_nFrames = 0;
+}
+
+
+const uint16_t* MappedRawFile::frame(int index)
+{
+	if ((index < 0) || (index >= m_nFrames)) return nullptr;
+
+	int w = index / m_windowFrames;
+	uchar* ptr;
+	{
+		std::unique_lock<std::mutex> lock(m_mtx);
+
+		// Release the windows out of [w - 1, w + 1]
+		for (auto it = m_windows.begin(); it != m_windows.end(); )
+		{
+			if (((it->first < w - 1) || (it->first > w + 1)) && (it->second.pinned == 0))
+			{
+				m_file.unmap(it->second.ptr);
+				it = m_windows.erase(it);
+			}
+			else
+				++it;
+		}
+
+		ptr = window(w);
+		if (!ptr) return nullptr;
+		m_windows[w].pinned++;
+
+		// Request prefetch of the next frames
+		if (m_prefetchFrames > 0)
+		{
+			m_prefetchTarget = std::min(index + 1 + m_prefetchFrames, m_nFrames);
+			if (m_prefetched <= index) m_prefetched = index + 1;
+		}
+	}
+	m_cv.notify_one();
+
+	return reinterpret_cast<const uint16_t*>(ptr + (qint64)(index - w * m_windowFrames) * m_frameBytes);
+}
+
+void MappedRawFile::release(int index)
+{
+	std::unique_lock<std::mutex> lock(m_mtx);
+
+	auto it = m_windows.find(index / m_windowFrames);
+	if ((it != m_windows.end()) && (it->second.pinned > 0))
+		it->second.pinned--;
+}
+
+uchar* MappedRawFile::window(int w)
+{
+	auto it = m_windows.find(w);
+	if (it != m_windows.end())
+		return it->second.ptr;
+
+	qint64 offset = (qint64)w * m_windowFrames * m_frameBytes;
+	qint64 size = (qint64)std::min(m_windowFrames, m_nFrames - w * m_windowFrames) * m_frameBytes;
+
+	uchar* ptr = m_file.map(offset, size);
+	if (!ptr)
+	{
+		printf("[ERROR] Failed to map the raw data. (window %d)\n", w);
+		return nullptr;
+	}
+
+#if !defined(_WIN32)
+	// Sequential read-ahead
+	uintptr_t page = (uintptr_t)sysconf(_SC_PAGESIZE);
+	uchar* aligned = reinterpret_cast<uchar*>((uintptr_t)ptr & ~(page - 1));
+	madvise(aligned, (size_t)(size + (ptr - aligned)), MADV_SEQUENTIAL);
+#endif
+
+	Window entry = { ptr, 0 };
+	m_windows[w] = entry;
+
+	return ptr;
+}
+
+void MappedRawFile::prefetch()
+{
+	volatile uchar sink = 0;
+
+	while (true)
+	{
+		std::unique_lock<std::mutex> lock(m_mtx);
+		m_cv.wait(lock, [&] { return !m_bRunning || (m_prefetched < m_prefetchTarget); });
+		if (!m_bRunning) break;
+
+		int index = m_prefetched++;
+		int w = index / m_windowFrames;
+		uchar* ptr = window(w);
+		if (!ptr) continue;
+
+		// Pin the window and touch a byte per page without the lock (frame() is not blocked by the page faults)
+		m_windows[w].pinned++;
+		lock.unlock();
+
+		const uchar* frame = ptr + (qint64)(index - w * m_windowFrames) * m_frameBytes;
+		for (qint64 i = 0; i < m_frameBytes; i += PAGE_SIZE_TOUCH)
+			sink += frame[i];
+
+		lock.lock();
+		m_windows[w].pinned--;
+	}
+}
@@ -0,0 +1,62 @@
+#ifndef MAPPEDRAWFILE_H
+#define MAPPEDRAWFILE_H
+
+#include <QString>
+#include <QFile>
+
+#include <iostream>
+#include <algorithm>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <map>
+
+#include <Havana2/Configuration.h>
+
+// Zero-copy reader of raw OCT data (*.data), mapped in sliding windows of MAPPED_WINDOW_FRAMES frames
+// A returned frame pointer is valid until release() is called for it.
+
+class MappedRawFile
+{
+public:
+	explicit MappedRawFile(int windowFrames = MAPPED_WINDOW_FRAMES, int prefetchFrames = MAPPED_PREFETCH_FRAMES);
+	virtual ~MappedRawFile();
+
+private: // Not to call copy constrcutor and copy assignment operator
+	MappedRawFile(const MappedRawFile&);
+	MappedRawFile& operator=(const MappedRawFile&);
+
+public:
+	bool open(const QString& path, int frameSize);
+	void close();
+
+	const uint16_t* frame(int index);
+	void release(int index);
+	inline int nFrames() const { return m_nFrames; }
+
+private:
+	uchar* window(int w); // should be called with m_mtx locked
+	void prefetch();
+
+private:
+	QFile m_file;
+	int m_windowFrames, m_prefetchFrames;
+	qint64 m_frameBytes;
+	int m_nFrames;
+
+	struct Window
+	{
+		uchar* ptr;
+		int pinned; // unreleased frames
+	};
+	std::map<int, Window> m_windows;
+
+	std::thread m_prefetchThread;
+	std::mutex m_mtx;
+	std::condition_variable m_cv;
+	int m_prefetchTarget; // prefetch frames up to (exclusive)
+	int m_prefetched;
+	bool m_bRunning;
+};
+
+#endif // MAPPEDRAWFILE_H
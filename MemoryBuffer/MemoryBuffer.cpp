@@ -5,15 +5,18 @@
 #include <Havana2/QOperationTab.h>
 #include <Havana2/QDeviceControlTab.h>
 
+#include <MemoryBuffer/OctDataFile.h>
+
 #include <QtCore/QFile>
 #include <QtWidgets/QMessageBox.h>
 
 
 MemoryBuffer::MemoryBuffer(QObject *parent) :
     QObject(parent),
-	m_bIsAllocatedWritingBuffer(false), 
-	m_bIsRecording(false), m_bIsSaved(false),
-	m_nRecordedFrames(0)
+	m_bIsAllocatedWritingBuffer(false),
+	m_bIsRecording(false), m_bIsSaved(false), m_bIsSaving(false),
+	m_nRecordedFrames(0), m_nFrameSize(0),
+	m_bIsBuffering(false), m_nBufferedFrames(0), m_bCompressedSaving(false)
 {
 	m_pOperationTab = (QOperationTab*)parent;
 	m_pMainWnd = m_pOperationTab->getMainWnd();
@@ -22,19 +25,12 @@ MemoryBuffer::MemoryBuffer(QObject *parent) :
 
 MemoryBuffer::~MemoryBuffer()
 {
-	for (int i = 0; i < WRITING_BUFFER_SIZE; i++)
+	if (!m_writingChunks.empty())
 	{
-		if (!m_queueWritingBuffer.empty())
-		{
-			uint16_t* buffer = m_queueWritingBuffer.front();
-			if (buffer)
-			{
-				m_queueWritingBuffer.pop();
-				delete[] buffer;
-			}
-		}
+		for (uint16_t* chunk : m_writingChunks)
+			delete[] chunk;
+		printf("Writing buffers are successfully disallocated.\n");
 	}
-	printf("Writing buffers are successfully disallocated.\n");
 }
 
 
@@ -42,13 +38,29 @@ void MemoryBuffer::allocateWritingBuffer()
 {
 	if (!m_bIsAllocatedWritingBuffer)
 	{
-		int nFrameSize = m_pConfig->nFrameSize;
-		for (int i = 0; i < WRITING_BUFFER_SIZE; i++)
+		// Writing buffer in chunks of WRITING_CHUNK_FRAMES (i-th frame of a recording is stored in i-th slot)
+		// Chunks are contiguous for the chunked writes, but a multi-GB contiguous allocation is not required.
+		m_nFrameSize = m_pConfig->nFrameSize;
+		m_frameHeader.resize(WRITING_BUFFER_SIZE);
+		try
+		{
+			for (int i = 0; i < WRITING_BUFFER_SIZE; i += WRITING_CHUNK_FRAMES)
+			{
+				int nFrames = std::min(WRITING_CHUNK_FRAMES, WRITING_BUFFER_SIZE - i);
+				m_writingChunks.push_back(new uint16_t[(size_t)m_nFrameSize * (size_t)nFrames]);
+				memset(m_writingChunks.back(), 0, (size_t)m_nFrameSize * (size_t)nFrames * sizeof(uint16_t));
+				printf("\rAllocating the writing buffers... [%d / %d]", i + nFrames, WRITING_BUFFER_SIZE);
+			}
+		}
+		catch (std::bad_alloc&)
 		{
-			uint16_t* buffer = new uint16_t[nFrameSize];
-			memset(buffer, 0, nFrameSize * sizeof(uint16_t));
-			m_queueWritingBuffer.push(buffer);
-			printf("\rAllocating the writing buffers... [%d / %d]", i + 1, WRITING_BUFFER_SIZE);
+			for (uint16_t* chunk : m_writingChunks)
+				delete[] chunk;
+			m_writingChunks.clear();
+
+			printf("\n[ERROR] Failed to allocate the writing buffers. Recording is not available.\n");
+			emit finishedBufferAllocation();
+			return;
 		}
 		printf("\nWriting buffers are successfully allocated. [Number of buffers: %d]\n", WRITING_BUFFER_SIZE);
 		printf("Now, recording process is available!\n");
@@ -90,6 +102,11 @@ bool MemoryBuffer::startRecording()
 	// Start Recording
 	printf("Data recording is started.\n");
 	m_nRecordedFrames = 0;
+	{
+		std::unique_lock<std::mutex> lock(m_mtxBuffering);
+		m_nBufferedFrames = 0;
+		m_bIsBuffering = true;
+	}
 
 	m_pDeviceControlTab = m_pMainWnd->m_pDeviceControlTab;
 
@@ -98,7 +115,7 @@ bool MemoryBuffer::startRecording()
 	if (m_pDeviceControlTab->isZaberStageEnabled())
 		m_pDeviceControlTab->pullback();
 #endif
-	
+
 	// Start Recording
 	m_bIsRecording = true;
 	m_bIsSaved = false;
@@ -106,28 +123,39 @@ bool MemoryBuffer::startRecording()
 	// Thread for buffering transfered data (memcpy)
 	std::thread	thread_buffering_data = std::thread([&]() {
 		printf("Data buffering thread is started.\n");
-		int nFrameSize = m_pConfig->nFrameSize;
 		while (1)
 		{
 			// Get the buffer from the buffering sync Queue
-			uint16_t* frame = m_syncBuffering.Queue_sync.pop();
-			if (frame)
+			uint16_t* frame_ptr = m_syncBuffering.Queue_sync.pop();
+			if (frame_ptr)
 			{
 				// Body
-				uint16_t* buffer = m_queueWritingBuffer.front();
-				m_queueWritingBuffer.pop();
-				memcpy(buffer, frame, sizeof(uint16_t) * nFrameSize);
-				m_queueWritingBuffer.push(buffer);
+				memcpy(frame(m_nBufferedFrames), frame_ptr, sizeof(uint16_t) * m_nFrameSize);
+				m_frameHeader[m_nBufferedFrames] = *frame_header(frame_ptr);
+
+				// Notify the writing thread that a frame is completed
+				{
+					std::unique_lock<std::mutex> lock(m_mtxBuffering);
+					m_nBufferedFrames++;
+				}
+				m_cvBuffering.notify_one();
 
 				// Return (push) the buffer to the buffering threading queue
 				{
 					std::unique_lock<std::mutex> lock(m_syncBuffering.mtx);
-					m_syncBuffering.queue_buffer.push(frame);
+					m_syncBuffering.queue_buffer.push(frame_ptr);
 				}
 			}
 			else
 				break;
 		}
+
+		{
+			std::unique_lock<std::mutex> lock(m_mtxBuffering);
+			m_bIsBuffering = false;
+		}
+		m_cvBuffering.notify_one();
+
 		printf("Data copying thread is finished.\n");
 	});
 	thread_buffering_data.detach();
@@ -139,14 +167,22 @@ void MemoryBuffer::stopRecording()
 {
 	// Stop recording
 	m_bIsRecording = false;
-		
-	if (m_nRecordedFrames != 0) // Not allowed when 'discard'
+
+	bool buffering;
 	{
+		std::unique_lock<std::mutex> lock(m_mtxBuffering);
+		buffering = m_bIsBuffering;
+	}
+
+	if (buffering) // Not allowed when 'discard' or 'cancel'
+	{
+		// Frame count before the end of buffering (read by the writing thread)
+		m_pConfig->nFrames = m_nRecordedFrames;
+
 		// Push nullptr to Buffering Queue
 		m_syncBuffering.Queue_sync.push(nullptr);
 
 		// Status update
-		m_pConfig->nFrames = m_nRecordedFrames;
 		uint64_t total_size = (uint64_t)m_nRecordedFrames * (uint64_t)(m_pConfig->nFrameSize * sizeof(uint16_t)) / (uint64_t)1024;
 		printf("Data recording is finished normally. \n(Recorded frames: %d frames (%1.3f GB)\n", m_nRecordedFrames, (double)total_size / 1024.0 / 1024.0);
 	}
@@ -155,123 +191,170 @@ void MemoryBuffer::stopRecording()
 bool MemoryBuffer::startSaving()
 {
 	// Get path to write
-	m_fileName = QFileDialog::getSaveFileName(nullptr, "Save As", "", "OCT raw data (*.data)");
+	QString selectedFilter;
+	m_fileName = QFileDialog::getSaveFileName(nullptr, "Save As", "",
+		"OCT raw data (*.data);;OCT data container (*.hvd);;Compressed OCT data container (*.hvd)", &selectedFilter);
 	if (m_fileName == "") return false;
-	
-	// Start writing thread
+	m_bCompressedSaving = selectedFilter.startsWith("Compressed");
+
+	// Start writing thread (also available while recording)
+	m_bIsSaving = true;
 	std::thread _thread = std::thread(&MemoryBuffer::write, this);
 	_thread.detach();
 
 	return true;
 }
 
-void MemoryBuffer::circulation(int nFramesToCirc)
-{
-	for (int i = 0; i < nFramesToCirc; i++)
-	{
-		uint16_t* buffer = m_queueWritingBuffer.front();
-		m_queueWritingBuffer.pop();
-		m_queueWritingBuffer.push(buffer);
-	}
-}
 
-uint16_t* MemoryBuffer::pop_front()
+int MemoryBuffer::waitForFrames(int nWrittenFrames)
 {
-	uint16_t* buffer = m_queueWritingBuffer.front();
-	m_queueWritingBuffer.pop();
+	// Wait until a new frame is buffered or the recording is finished
+	std::unique_lock<std::mutex> lock(m_mtxBuffering);
+	m_cvBuffering.wait(lock, [&]() { return (m_nBufferedFrames > nWrittenFrames) || !m_bIsBuffering; });
 
-	return buffer;
+	return m_nBufferedFrames;
 }
 
-void MemoryBuffer::push_back(uint16_t* buffer)
+void MemoryBuffer::notifyProgress(int nWrittenFrames, bool force)
 {
-	m_queueWritingBuffer.push(buffer);
+	// Throttled progress signal
+	std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+	if (force || (now - m_lastProgress > std::chrono::milliseconds(PROGRESS_UPDATE_INTERVAL)))
+	{
+		emit wroteSingleFrame(nWrittenFrames - 1);
+		m_lastProgress = now;
+	}
 }
 
-
 void MemoryBuffer::write()
-{	
-	qint64 res, samplesToWrite = m_pConfig->nFrameSize / 8;
-
+{
 	if (QFile::exists(m_fileName))
 	{
 		printf("Havana2 does not overwrite a recorded data.\n");
+		m_bIsSaving = false;
 		emit finishedWritingThread(true);
 		return;
 	}
 
-	// Move to start point
-	uint16_t* buffer = nullptr;
-	for (int i = 0; i < WRITING_BUFFER_SIZE - m_nRecordedFrames; i++)
+	// Writing
+	bool container = m_fileName.endsWith(".hvd", Qt::CaseInsensitive);
+	if (container)
 	{
-		buffer = m_queueWritingBuffer.front();
-		m_queueWritingBuffer.pop();
-		m_queueWritingBuffer.push(buffer);
-	}	
-
-	// Writing 
-	QFile file(m_fileName);
-	if (file.open(QIODevice::WriteOnly))
+		if (!writeContainer())
+		{
+			m_bIsSaving = false;
+			emit finishedWritingThread(true);
+			return;
+		}
+	}
+	else
 	{
-		for (int i = 0; i < m_nRecordedFrames; i++)
+		QFile file(m_fileName);
+		if (file.open(QIODevice::WriteOnly))
 		{
-			buffer = m_queueWritingBuffer.front();
-			m_queueWritingBuffer.pop();
-
-			for (int j = 0; j < 8; j++)
+			int nWrittenFrames = 0, nBufferedFrames;
+			while ((nBufferedFrames = waitForFrames(nWrittenFrames)) > nWrittenFrames)
 			{
-				res = file.write(reinterpret_cast<char*>(buffer + j * samplesToWrite), sizeof(uint16_t) * samplesToWrite);
-				if (!(res == sizeof(uint16_t) * samplesToWrite))
+				// Completed frames are contiguous within a chunk of the writing buffer
+				while (nWrittenFrames < nBufferedFrames)
 				{
-					printf("Error occurred while writing...\n");
-					emit finishedWritingThread(true);
-					return;
+					int nFramesToWrite = std::min(nBufferedFrames - nWrittenFrames, WRITING_CHUNK_FRAMES - nWrittenFrames % WRITING_CHUNK_FRAMES);
+					qint64 bytesToWrite = (qint64)sizeof(uint16_t) * m_nFrameSize * nFramesToWrite;
+					if (file.write(reinterpret_cast<char*>(frame(nWrittenFrames)), bytesToWrite) != bytesToWrite)
+					{
+						printf("Error occurred while writing...\n");
+						m_bIsSaving = false;
+						emit finishedWritingThread(true);
+						return;
+					}
+					nWrittenFrames += nFramesToWrite;
+					notifyProgress(nWrittenFrames);
 				}
 			}
-			emit wroteSingleFrame(i);
-			//printf("\r%dth frame is wrote... [%3.2f%%]", i + 1, 100 * (double)(i + 1) / (double)m_nRecordedFrames);
-
-			m_queueWritingBuffer.push(buffer);
+			notifyProgress(nWrittenFrames, true);
+			file.close();
+		}
+		else
+		{
+			printf("Error occurred during writing process.\n");
+			m_bIsSaving = false;
+			emit finishedWritingThread(true);
+			return;
 		}
-		file.close();
-	}
-	else
-	{
-		printf("Error occurred during writing process.\n");
-		return;
 	}
 	m_bIsSaved = true;
+	m_bIsSaving = false;
+
+	// Move files (configuration, calibration & background are embedded in the container)
+	if (!container)
+	{
+		QString fileTitle, filePath;
+		for (int i = 0; i < m_fileName.length(); i++)
+		{
+			if (m_fileName.at(i) == QChar('.')) fileTitle = m_fileName.left(i);
+			if (m_fileName.at(i) == QChar('/')) filePath = m_fileName.left(i);
+		}
 
-	// Move files
-	QString fileTitle, filePath;
-	for (int i = 0; i < m_fileName.length(); i++)
-	{		
-		if (m_fileName.at(i) == QChar('.')) fileTitle = m_fileName.left(i);
-		if (m_fileName.at(i) == QChar('/')) filePath = m_fileName.left(i);
-	}	
+		m_pConfig->setConfigFile("Havana2.ini");
+		if (false == QFile::copy("Havana2.ini", fileTitle + ".ini"))
+			printf("Error occurred while copying configuration data.\n");
+
+		if (false == QFile::copy("calibration.dat", fileTitle + ".calibration"))
+			printf("Error occurred while copying calibration data.\n");
+		if (false == QFile::copy("bg.bin", fileTitle + ".background"))
+			printf("Error occurred while copying background data.\n");
+		if (false == QFile::copy("d1.bin", filePath + "/d1.bin"))
+			printf("Error occurred while copying d1 data.\n");
+		if (false == QFile::copy("d2.bin", filePath + "/d2.bin"))
+			printf("Error occurred while copying d2 data.\n");
+
+		if (false == QFile::copy("Lumen_IP_havana2.m", filePath + "/Lumen_IP_havana2.m"))
+			printf("Error occurred while copying MATLAB processing data.\n");
+	}
 
-	m_pConfig->setConfigFile("Havana2.ini");
-	if (false == QFile::copy("Havana2.ini", fileTitle + ".ini"))
-		printf("Error occurred while copying configuration data.\n");
-
-	if (false == QFile::copy("calibration.dat", fileTitle + ".calibration"))
-		printf("Error occurred while copying calibration data.\n");
-	if (false == QFile::copy("bg.bin", fileTitle + ".background"))
-		printf("Error occurred while copying background data.\n");
-	if (false == QFile::copy("d1.bin", filePath + "/d1.bin"))
-		printf("Error occurred while copying d1 data.\n");
-	if (false == QFile::copy("d2.bin", filePath + "/d2.bin"))
-		printf("Error occurred while copying d2 data.\n");
-
-	if (false == QFile::copy("Lumen_IP_havana2.m", filePath + "/Lumen_IP_havana2.m"))
-		printf("Error occurred while copying MATLAB processing data.\n");
-	
 	// Send a signal to notify this thread is finished
 	emit finishedWritingThread(false);
 
 	// Status update
-	printf("\nData saving thread is finished normally. (Saved frames: %d frames)\n", m_nRecordedFrames);
+	printf("\nData saving thread is finished normally. (Saved frames: %d frames)\n", m_nBufferedFrames);
 	QByteArray temp = m_fileName.toLocal8Bit();
 	char* filename = temp.data();
 	printf("[%s]\n", filename);
 }
+
+bool MemoryBuffer::writeContainer()
+{
+	OctDataFile dataFile;
+	if (!dataFile.create(m_fileName, m_pConfig->nScans, m_pConfig->nAlines, m_bCompressedSaving))
+		return false;
+
+	// Header sections
+	m_pConfig->setConfigFile("Havana2.ini");
+	dataFile.addSectionFromFile(OCT_SECTION_CONFIG, "Havana2.ini");
+	dataFile.addSectionFromFile(OCT_SECTION_CALIBRATION, "calibration.dat");
+	dataFile.addSectionFromFile(OCT_SECTION_BACKGROUND, "bg.bin");
+	dataFile.addSectionFromFile(OCT_SECTION_DISPERSION1, "d1.bin");
+	dataFile.addSectionFromFile(OCT_SECTION_DISPERSION2, "d2.bin");
+
+	// Frame chunks (appended as soon as the frames are buffered)
+	int nWrittenFrames = 0, nBufferedFrames;
+	while ((nBufferedFrames = waitForFrames(nWrittenFrames)) > nWrittenFrames)
+	{
+		for (; nWrittenFrames < nBufferedFrames; nWrittenFrames++)
+		{
+			if (!dataFile.appendFrame(frame(nWrittenFrames), m_frameHeader[nWrittenFrames]))
+			{
+				printf("Error occurred while writing...\n");
+				return false;
+			}
+			notifyProgress(nWrittenFrames + 1);
+		}
+	}
+	notifyProgress(nWrittenFrames, true);
+
+	// Final configuration (frame count) replaces the snapshot at the start of saving
+	m_pConfig->setConfigFile("Havana2.ini");
+	dataFile.addSectionFromFile(OCT_SECTION_CONFIG, "Havana2.ini");
+
+	return dataFile.finalize();
+}
@@ -5,8 +5,16 @@
 
 #include <iostream>
 #include <thread>
-#include <queue>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+#include <algorithm>
+#include <vector>
+#include <atomic>
 
+#include <Havana2/Configuration.h>
+
+#include <Common/array.h>
 #include <Common/SyncObject.h>
 
 class MainWindow;
@@ -34,15 +42,14 @@ public:
     // Data saving (save wrote data to hard disk)
     bool startSaving();
 
-	// Circulation
-	void circulation(int nFramesToCirc);
-
-	// Buffer operation
-	uint16_t* pop_front();
-	void push_back(uint16_t* buffer);
+	// Buffer operation (i-th frame of the recording)
+	inline uint16_t* frame(int index) { return m_writingChunks[index / WRITING_CHUNK_FRAMES] + (size_t)(index % WRITING_CHUNK_FRAMES) * (size_t)m_nFrameSize; }
 
 private: // writing threading operation
 	void write();
+	bool writeContainer();
+	int waitForFrames(int nWrittenFrames);
+	void notifyProgress(int nWrittenFrames, bool force = false);
 
 signals:
 	void wroteSingleFrame(int);
@@ -59,14 +66,25 @@ public:
 	bool m_bIsAllocatedWritingBuffer;
 	bool m_bIsRecording;
 	bool m_bIsSaved;
+	std::atomic<bool> m_bIsSaving;
 	int m_nRecordedFrames;
 
 public:
 	SyncObject<uint16_t> m_syncBuffering;
+	std::vector<FrameHeader> m_frameHeader; // header of each recorded frame
 
 private:
-    std::queue<uint16_t*> m_queueWritingBuffer; // writing buffer
+	std::vector<uint16_t*> m_writingChunks; // writing buffer (WRITING_BUFFER_SIZE frames in chunks of WRITING_CHUNK_FRAMES)
+	int m_nFrameSize;
+
+	std::atomic<bool> m_bIsBuffering;
+	int m_nBufferedFrames; // frames copied to the writing buffer
+	std::mutex m_mtxBuffering;
+	std::condition_variable m_cvBuffering;
+
 	QString m_fileName;
+	bool m_bCompressedSaving;
+	std::chrono::steady_clock::time_point m_lastProgress;
 };
 
 #endif // MEMORYBUFFER_H
@@ -0,0 +1,482 @@
+
+#include "OctDataFile.h"
+
+#include <QTemporaryFile>
+
+#include <Common/crc32.h>
+
+
+OctDataFile::OctDataFile() :
+	m_bWriting(false), m_bLegacy(false), m_sectionOffset(0), m_endOffset(0)
+{
+	memset(&m_header, 0, sizeof(OctFileHeader));
+}
+
+OctDataFile::~OctDataFile()
+{
+	close();
+}
+
+
+bool OctDataFile::create(const QString& path, int nScans, int nAlines, bool compressed)
+{
+	close();
+
+	m_file.setFileName(path);
+	if (!m_file.open(QIODevice::WriteOnly))
+	{
+		printf("[ERROR] Cannot create the data file.\n");
+		return false;
+	}
+
+	// Initialize header
+	memset(&m_header, 0, sizeof(OctFileHeader));
+	memcpy(m_header.magic, OCT_FILE_MAGIC, 4);
+	m_header.version = OCT_FILE_VERSION;
+	m_header.flags = compressed ? OCT_FILE_COMPRESSED : 0;
+	m_header.nScans = nScans;
+	m_header.nAlines = nAlines;
+
+	if (compressed)
+	{
+		m_codec = fringe_codec(nScans, nAlines);
+		m_packed = np::Array<uint8_t>(m_codec.bound());
+		m_header.blockAlines = m_codec.blockAlines;
+	}
+
+	m_sections.clear();
+	m_trailingSections.clear();
+	m_index.clear();
+	m_endOffset = 0;
+	m_bWriting = true;
+
+	return m_file.write(reinterpret_cast<char*>(&m_header), sizeof(OctFileHeader)) == sizeof(OctFileHeader);
+}
+
+bool OctDataFile::addSection(const char* tag, const QByteArray& data)
+{
+	if (!m_bWriting) return false;
+
+	// Sections added after the first frame are written at the finalization
+	if (m_endOffset != 0)
+		m_trailingSections.insert(QByteArray(tag, 4), data);
+	else if (!writeSection(tag, data))
+		return false;
+
+	m_sections.insert(QByteArray(tag, 4), data);
+
+	return true;
+}
+
+bool OctDataFile::addSectionFromFile(const char* tag, const QString& path)
+{
+	QFile file(path);
+	if (!file.open(QIODevice::ReadOnly))
+	{
+		QByteArray temp = path.toLocal8Bit();
+		printf("Error occurred while embedding %s.\n", temp.data());
+		return false;
+	}
+
+	return addSection(tag, file.readAll());
+}
+
+bool OctDataFile::writeSection(const char* tag, const QByteArray& data)
+{
+	OctSectionHeader section;
+	memcpy(section.tag, tag, 4);
+	section.size = (uint32_t)data.size();
+
+	return (m_file.write(reinterpret_cast<char*>(&section), sizeof(OctSectionHeader)) == sizeof(OctSectionHeader))
+		&& (m_file.write(data) == data.size());
+}
+
+bool OctDataFile::beginData()
+{
+	OctSectionHeader section;
+	memcpy(section.tag, OCT_SECTION_DATA, 4);
+	section.size = 0;
+
+	if (m_file.write(reinterpret_cast<char*>(&section), sizeof(OctSectionHeader)) != sizeof(OctSectionHeader))
+		return false;
+
+	m_header.dataOffset = m_file.pos();
+	m_endOffset = m_header.dataOffset;
+
+	return true;
+}
+
+bool OctDataFile::appendFrame(const uint16_t* frame, const FrameHeader& header)
+{
+	if (!m_bWriting) return false;
+	if ((m_endOffset == 0) && !beginData()) return false;
+
+	// Chunk header
+	OctChunkHeader chunk;
+	memset(&chunk, 0, sizeof(OctChunkHeader));
+	memcpy(chunk.magic, OCT_CHUNK_MAGIC, 4);
+	chunk.seq = header.seq;
+	chunk.timestamp = header.timestamp;
+	chunk.frameFlags = header.flags;
+
+	const char* payload;
+	if (m_header.flags & OCT_FILE_COMPRESSED)
+	{
+		chunk.flags = OCT_CHUNK_COMPRESSED;
+		chunk.size = (uint32_t)m_codec.encode(frame, m_packed.raw_ptr());
+		payload = reinterpret_cast<const char*>(m_packed.raw_ptr());
+	}
+	else
+	{
+		chunk.size = (uint32_t)(sizeof(uint16_t) * m_header.nScans * m_header.nAlines);
+		payload = reinterpret_cast<const char*>(frame);
+	}
+	chunk.crc = crc32::instance()(payload, chunk.size);
+
+	// Write & flush (visible to the readers)
+	if ((m_file.write(reinterpret_cast<char*>(&chunk), sizeof(OctChunkHeader)) != sizeof(OctChunkHeader))
+		|| (m_file.write(payload, chunk.size) != (qint64)chunk.size))
+	{
+		printf("[ERROR] Error occurred while writing a frame chunk.\n");
+		return false;
+	}
+	m_file.flush();
+
+	OctIndexEntry entry = { m_endOffset, header.timestamp, header.seq, chunk.size };
+	m_index.push_back(entry);
+	m_endOffset += sizeof(OctChunkHeader) + chunk.size;
+
+	return true;
+}
+
+bool OctDataFile::finalize()
+{
+	if (!m_bWriting) return false;
+	if ((m_endOffset == 0) && !beginData()) return false;
+
+	// 1. Trailing sections, frame index & trailer
+	bool ok = true;
+	for (auto it = m_trailingSections.constBegin(); ok && (it != m_trailingSections.constEnd()); ++it)
+		ok = writeSection(it.key().constData(), it.value());
+
+	OctIndexHeader index;
+	memcpy(index.magic, OCT_INDEX_MAGIC, 4);
+	index.nFrames = (int32_t)m_index.size();
+
+	OctFileTrailer trailer;
+	memset(&trailer, 0, sizeof(OctFileTrailer));
+	trailer.indexOffset = m_file.pos();
+	trailer.nFrames = index.nFrames;
+	trailer.crc = crc32::instance()(m_index.data(), sizeof(OctIndexEntry) * m_index.size());
+	memcpy(trailer.magic, OCT_TRAILER_MAGIC, 4);
+
+	qint64 indexBytes = (qint64)(sizeof(OctIndexEntry) * m_index.size());
+	ok = ok && (m_file.write(reinterpret_cast<char*>(&index), sizeof(OctIndexHeader)) == sizeof(OctIndexHeader))
+		&& (m_file.write(reinterpret_cast<const char*>(m_index.data()), indexBytes) == indexBytes)
+		&& (m_file.write(reinterpret_cast<char*>(&trailer), sizeof(OctFileTrailer)) == sizeof(OctFileTrailer));
+	m_file.flush();
+
+	// 2. Patch the header at last (the file is regarded as finalized only after this step)
+	if (ok)
+	{
+		m_header.nFrames = index.nFrames;
+		m_header.indexOffset = trailer.indexOffset;
+		m_header.flags |= OCT_FILE_FINALIZED;
+
+		ok = m_file.seek(0) && (m_file.write(reinterpret_cast<char*>(&m_header), sizeof(OctFileHeader)) == sizeof(OctFileHeader));
+		m_file.flush();
+	}
+	if (!ok) printf("[ERROR] Error occurred while finalizing the data file.\n");
+
+	m_bWriting = false;
+	m_file.close();
+
+	return ok;
+}
+
+
+bool OctDataFile::open(const QString& path)
+{
+	close();
+
+	m_file.setFileName(path);
+	if (!m_file.open(QIODevice::ReadOnly))
+		return false;
+
+	// Compressed raw stream of the earlier recordings (*.cdata)
+	if (m_file.peek(4) == QByteArray(OCT_LEGACY_MAGIC, 4))
+		return openLegacy(path);
+
+	// Header
+	if ((m_file.read(reinterpret_cast<char*>(&m_header), sizeof(OctFileHeader)) != sizeof(OctFileHeader))
+		|| (memcmp(m_header.magic, OCT_FILE_MAGIC, 4) != 0) || (m_header.version > OCT_FILE_VERSION))
+	{
+		printf("[ERROR] Invalid data file header!\n");
+		m_file.close();
+		return false;
+	}
+
+	if (m_header.flags & OCT_FILE_COMPRESSED)
+	{
+		m_codec = fringe_codec(m_header.nScans, m_header.nAlines, m_header.blockAlines);
+		m_packed = np::Array<uint8_t>(m_codec.bound());
+	}
+
+	// Sections (continued by refresh() if the writer has not reached the frames yet)
+	m_sectionOffset = m_file.pos();
+	readSections();
+
+	// Frame index (scan the chunks if the file is not finalized)
+	if (isFinalized() && readIndex())
+		readTrailingSections();
+	else
+	{
+		printf("Frame index is not available. Scanning frame chunks...\n");
+		m_index.clear();
+		refresh();
+	}
+
+	return true;
+}
+
+bool OctDataFile::openLegacy(const QString& path)
+{
+	OctLegacyHeader legacy;
+	if (!m_file.seek(0)
+		|| (m_file.read(reinterpret_cast<char*>(&legacy), sizeof(OctLegacyHeader)) != sizeof(OctLegacyHeader))
+		|| (legacy.nScans <= 0) || (legacy.nAlines <= 0) || (legacy.blockAlines <= 0))
+	{
+		printf("[ERROR] Invalid compressed data header!\n");
+		m_file.close();
+		return false;
+	}
+
+	// Header of a compressed container (finalized if the frame count was patched)
+	memset(&m_header, 0, sizeof(OctFileHeader));
+	memcpy(m_header.magic, OCT_LEGACY_MAGIC, 4);
+	m_header.flags = OCT_FILE_COMPRESSED | ((legacy.nFrames > 0) ? OCT_FILE_FINALIZED : 0);
+	m_header.nScans = legacy.nScans;
+	m_header.nAlines = legacy.nAlines;
+	m_header.nFrames = legacy.nFrames;
+	m_header.dataOffset = sizeof(OctLegacyHeader);
+	m_header.blockAlines = legacy.blockAlines;
+
+	m_codec = fringe_codec(m_header.nScans, m_header.nAlines, m_header.blockAlines);
+	m_packed = np::Array<uint8_t>(m_codec.bound());
+	m_bLegacy = true;
+
+	// Sections from the files next to the stream
+	QString title = path.left(path.lastIndexOf('.'));
+	const char* tags[3] = { OCT_SECTION_CONFIG, OCT_SECTION_CALIBRATION, OCT_SECTION_BACKGROUND };
+	const char* suffixes[3] = { ".ini", ".calibration", ".background" };
+	for (int i = 0; i < 3; i++)
+	{
+		QFile file(title + suffixes[i]);
+		if (file.open(QIODevice::ReadOnly))
+			m_sections.insert(QByteArray(tags[i], 4), file.readAll());
+	}
+
+	// Frame index (scanning the sizes)
+	m_endOffset = m_header.dataOffset;
+	refresh();
+
+	return true;
+}
+
+bool OctDataFile::readSections()
+{
+	// Complete sections until the "DATA" marker
+	OctSectionHeader section;
+	while (m_file.seek(m_sectionOffset)
+		&& (m_file.read(reinterpret_cast<char*>(&section), sizeof(OctSectionHeader)) == sizeof(OctSectionHeader)))
+	{
+		if (memcmp(section.tag, OCT_SECTION_DATA, 4) == 0)
+		{
+			m_endOffset = m_file.pos();
+			return true;
+		}
+
+		QByteArray data = m_file.read(section.size);
+		if (data.size() != (int)section.size) break;
+		m_sections.insert(QByteArray(section.tag, 4), data);
+		m_sectionOffset = m_file.pos();
+	}
+
+	return false;
+}
+
+void OctDataFile::readTrailingSections()
+{
+	// Sections between the last chunk and the index (replace the ones written before the frames)
+	int64_t offset = m_index.empty() ? m_header.dataOffset : m_index.back().offset + (int64_t)sizeof(OctChunkHeader) + m_index.back().size;
+	OctSectionHeader section;
+	while ((offset + (int64_t)sizeof(OctSectionHeader) <= m_header.indexOffset) && m_file.seek(offset)
+		&& (m_file.read(reinterpret_cast<char*>(&section), sizeof(OctSectionHeader)) == sizeof(OctSectionHeader)))
+	{
+		offset += sizeof(OctSectionHeader) + section.size;
+		if (offset > m_header.indexOffset) break;
+
+		m_sections.insert(QByteArray(section.tag, 4), m_file.read(section.size));
+	}
+}
+
+bool OctDataFile::readIndex()
+{
+	OctFileTrailer trailer;
+	if (!m_file.seek(m_file.size() - (qint64)sizeof(OctFileTrailer))
+		|| (m_file.read(reinterpret_cast<char*>(&trailer), sizeof(OctFileTrailer)) != sizeof(OctFileTrailer))
+		|| (memcmp(trailer.magic, OCT_TRAILER_MAGIC, 4) != 0) || (trailer.indexOffset != m_header.indexOffset))
+		return false;
+
+	OctIndexHeader index;
+	if (!m_file.seek(trailer.indexOffset)
+		|| (m_file.read(reinterpret_cast<char*>(&index), sizeof(OctIndexHeader)) != sizeof(OctIndexHeader))
+		|| (memcmp(index.magic, OCT_INDEX_MAGIC, 4) != 0) || (index.nFrames != trailer.nFrames))
+		return false;
+
+	m_index.resize(index.nFrames);
+	qint64 indexBytes = (qint64)(sizeof(OctIndexEntry) * m_index.size());
+	if ((m_file.read(reinterpret_cast<char*>(m_index.data()), indexBytes) != indexBytes)
+		|| (crc32::instance()(m_index.data(), indexBytes) != trailer.crc))
+		return false;
+
+	m_endOffset = trailer.indexOffset;
+
+	return true;
+}
+
+bool OctDataFile::readChunkHeader(int64_t offset, OctChunkHeader& chunk)
+{
+	if (!m_file.seek(offset)
+		|| (m_file.read(reinterpret_cast<char*>(&chunk), sizeof(OctChunkHeader)) != sizeof(OctChunkHeader))
+		|| (memcmp(chunk.magic, OCT_CHUNK_MAGIC, 4) != 0))
+		return false;
+
+	// Size sanity check
+	uint32_t frameBytes = (uint32_t)(sizeof(uint16_t) * m_header.nScans * m_header.nAlines);
+	if (chunk.flags & OCT_CHUNK_COMPRESSED)
+		return (m_header.flags & OCT_FILE_COMPRESSED) && (chunk.size <= (uint32_t)m_codec.bound());
+	else
+		return chunk.size == frameBytes;
+}
+
+int OctDataFile::refresh()
+{
+	if (m_bWriting || !m_file.isOpen())
+		return nFrames();
+
+	// Sections written after the file was opened
+	if ((m_endOffset == 0) && (m_bLegacy || !readSections()))
+		return nFrames();
+
+	if (m_bLegacy)
+	{
+		// [uint32 size][frame] (complete frames only, up to the patched frame count)
+		uint32_t size;
+		while (!(isFinalized() && (nFrames() >= m_header.nFrames))
+			&& m_file.seek(m_endOffset) && (m_file.read(reinterpret_cast<char*>(&size), sizeof(uint32_t)) == sizeof(uint32_t)))
+		{
+			if ((size > (uint32_t)m_codec.bound()) || (m_endOffset + (int64_t)sizeof(uint32_t) + size > m_file.size()))
+				break;
+
+			OctIndexEntry entry = { m_endOffset, 0, (uint32_t)nFrames(), size };
+			m_index.push_back(entry);
+			m_endOffset += sizeof(uint32_t) + size;
+		}
+
+		return nFrames();
+	}
+
+	// Append the complete & valid chunks only
+	OctChunkHeader chunk;
+	while (readChunkHeader(m_endOffset, chunk))
+	{
+		if (m_endOffset + (int64_t)sizeof(OctChunkHeader) + chunk.size > m_file.size())
+			break;
+
+		QByteArray payload = m_file.read(chunk.size);
+		if ((payload.size() != (int)chunk.size) || (crc32::instance()(payload.constData(), chunk.size) != chunk.crc))
+			break;
+
+		OctIndexEntry entry = { m_endOffset, chunk.timestamp, chunk.seq, chunk.size };
+		m_index.push_back(entry);
+		m_endOffset += sizeof(OctChunkHeader) + chunk.size;
+	}
+
+	return nFrames();
+}
+
+bool OctDataFile::readFrame(int index, uint16_t* frame)
+{
+	if ((index < 0) || (index >= nFrames())) return false;
+
+	if (m_bLegacy)
+	{
+		const OctIndexEntry& entry = m_index.at(index);
+		if (!m_file.seek(entry.offset + sizeof(uint32_t))
+			|| (m_file.read(reinterpret_cast<char*>(m_packed.raw_ptr()), entry.size) != (qint64)entry.size)
+			|| !m_codec.decode(m_packed.raw_ptr(), (int)entry.size, frame))
+		{
+			printf("[ERROR] Corrupted compressed frame! (%d)\n", index);
+			return false;
+		}
+
+		return true;
+	}
+
+	OctChunkHeader chunk;
+	if (!readChunkHeader(m_index.at(index).offset, chunk))
+	{
+		printf("[ERROR] Invalid frame chunk! (%d)\n", index);
+		return false;
+	}
+
+	char* payload = (chunk.flags & OCT_CHUNK_COMPRESSED) ? reinterpret_cast<char*>(m_packed.raw_ptr()) : reinterpret_cast<char*>(frame);
+	if ((m_file.read(payload, chunk.size) != (qint64)chunk.size) || (crc32::instance()(payload, chunk.size) != chunk.crc))
+	{
+		printf("[ERROR] Corrupted frame chunk! (%d)\n", index);
+		return false;
+	}
+
+	if (chunk.flags & OCT_CHUNK_COMPRESSED)
+		return m_codec.decode(m_packed.raw_ptr(), (int)chunk.size, frame);
+
+	return true;
+}
+
+void OctDataFile::getConfiguration(Configuration& config) const
+{
+	// Configuration snapshot (QSettings reads the ini format from a file only)
+	QTemporaryFile iniFile;
+	if (iniFile.open())
+	{
+		iniFile.write(section(OCT_SECTION_CONFIG));
+		iniFile.close();
+		config.getConfigFile(iniFile.fileName());
+	}
+
+	// Frame size of the data
+	config.nScans = nScans();
+	config.nScansFFT = NEAR_2_POWER((double)config.nScans);
+	config.n2ScansFFT = config.nScansFFT / 2;
+	config.nAlines = nAlines();
+	config.nAlines4 = ((config.nAlines + 3) >> 2) << 2;
+	config.nFrameSize = config.nScans * config.nAlines;
+	config.nFrames = nFrames();
+}
+
+void OctDataFile::close()
+{
+	if (m_bWriting)
+		finalize();
+
+	if (m_file.isOpen())
+		m_file.close();
+
+	m_sections.clear();
+	m_trailingSections.clear();
+	m_index.clear();
+	m_sectionOffset = 0;
+	m_endOffset = 0;
+	m_bLegacy = false;
+}
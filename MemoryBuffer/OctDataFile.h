@@ -0,0 +1,161 @@
+#ifndef OCTDATAFILE_H
+#define OCTDATAFILE_H
+
+#include <QString>
+#include <QFile>
+#include <QByteArray>
+#include <QMap>
+
+#include <iostream>
+#include <vector>
+
+#include <Havana2/Configuration.h>
+
+#include <Common/array.h>
+#include <Common/fringe_codec.h>
+#include <Common/FrameHeader.h>
+
+// Havana2 OCT data container (*.hvd): header, sections, "DATA", frame chunks, trailing sections, index & trailer
+// Compressed raw streams of the earlier recordings (*.cdata) are read as containers as well (read-only).
+
+#define OCT_FILE_MAGIC				"HVD1"
+#define OCT_CHUNK_MAGIC				"FRM1"
+#define OCT_INDEX_MAGIC				"IDX1"
+#define OCT_TRAILER_MAGIC			"HVDE"
+#define OCT_FILE_VERSION			1
+#define OCT_LEGACY_MAGIC			"HVZ1" // *.cdata
+
+#define OCT_SECTION_CONFIG			"CONF" // Havana2.ini
+#define OCT_SECTION_CALIBRATION		"CALB" // calibration.dat
+#define OCT_SECTION_BACKGROUND		"BKGD" // bg.bin
+#define OCT_SECTION_DISPERSION1		"DSP1" // d1.bin
+#define OCT_SECTION_DISPERSION2		"DSP2" // d2.bin
+#define OCT_SECTION_DATA			"DATA" // end of sections
+
+#define OCT_FILE_COMPRESSED			0x1
+#define OCT_FILE_FINALIZED			0x2
+#define OCT_CHUNK_COMPRESSED		0x1
+
+#pragma pack(push, 1)
+struct OctFileHeader
+{
+	char magic[4];
+	uint32_t version;
+	uint32_t flags;
+	int32_t nScans;
+	int32_t nAlines;
+	int32_t nFrames; // valid only if finalized
+	int64_t dataOffset; // first chunk
+	int64_t indexOffset; // valid only if finalized
+	int32_t blockAlines; // fringe_codec block size
+	int32_t reserved[5];
+};
+
+struct OctSectionHeader
+{
+	char tag[4];
+	uint32_t size;
+};
+
+struct OctChunkHeader
+{
+	char magic[4];
+	uint32_t seq; // acquisition frame number
+	int64_t timestamp; // monotonic clock [us]
+	uint32_t flags;
+	uint32_t size; // payload size
+	uint32_t crc; // payload CRC-32
+	uint32_t frameFlags; // FRAME_FLAG_*
+};
+
+struct OctIndexHeader
+{
+	char magic[4];
+	int32_t nFrames;
+};
+
+struct OctIndexEntry
+{
+	int64_t offset; // chunk header
+	int64_t timestamp;
+	uint32_t seq;
+	uint32_t size;
+};
+
+struct OctLegacyHeader
+{
+	char magic[4];
+	int32_t nScans;
+	int32_t nAlines;
+	int32_t nFrames; // 0 if the stream was not closed
+	int32_t blockAlines;
+	int32_t reserved[3];
+};
+
+struct OctFileTrailer
+{
+	int64_t indexOffset;
+	int32_t nFrames;
+	uint32_t crc; // index CRC-32
+	char magic[4];
+	uint32_t reserved;
+};
+#pragma pack(pop)
+
+
+class OctDataFile
+{
+public:
+	explicit OctDataFile();
+	virtual ~OctDataFile();
+
+public: // Writing
+	bool create(const QString& path, int nScans, int nAlines, bool compressed = false);
+	bool addSection(const char* tag, const QByteArray& data); // written at the finalization if called after the first frame
+	bool addSectionFromFile(const char* tag, const QString& path);
+	bool appendFrame(const uint16_t* frame, const FrameHeader& header);
+	bool finalize();
+
+public: // Reading
+	bool open(const QString& path);
+	int refresh(); // scan sections & chunks appended after the last read ones (read-while-write, crash recovery)
+	bool readFrame(int index, uint16_t* frame);
+	void close();
+
+	QByteArray section(const char* tag) const { return m_sections.value(QByteArray(tag, 4)); }
+	void getConfiguration(Configuration& config) const; // embedded configuration & frame size of the data
+	const OctIndexEntry& frameInfo(int index) const { return m_index.at(index); }
+	bool isFinalized() const { return (m_header.flags & OCT_FILE_FINALIZED) != 0; }
+	bool isLegacy() const { return m_bLegacy; }
+
+public:
+	inline int nScans() const { return m_header.nScans; }
+	inline int nAlines() const { return m_header.nAlines; }
+	inline int nFrames() const { return (int)m_index.size(); }
+
+private:
+	bool writeSection(const char* tag, const QByteArray& data);
+	bool beginData();
+	bool openLegacy(const QString& path);
+	bool readSections();
+	void readTrailingSections();
+	bool readIndex();
+	bool readChunkHeader(int64_t offset, OctChunkHeader& chunk);
+
+private:
+	QFile m_file;
+	bool m_bWriting;
+	bool m_bLegacy; // *.cdata stream
+
+	OctFileHeader m_header;
+	QMap<QByteArray, QByteArray> m_sections;
+	QMap<QByteArray, QByteArray> m_trailingSections; // added after the first frame
+	std::vector<OctIndexEntry> m_index;
+	int64_t m_sectionOffset; // next section to read (until the "DATA" marker)
+	int64_t m_endOffset; // end of the last valid chunk (0 before the "DATA" marker)
+
+	fringe_codec m_codec;
+	np::Array<uint8_t> m_packed;
+};
+
+#endif // OCTDATAFILE_H
@@ -0,0 +1,109 @@
+
+#include "OctResultCache.h"
+
+#include <QFileInfo>
+#include <QDateTime>
+#include <QCryptographicHash>
+
+#ifdef OCT_DB_FIXED_POINT
+#define OCT_RESULT_FRAC_BITS OCT_DB_FRAC_BITS
+#else
+#define OCT_RESULT_FRAC_BITS 0
+#endif
+
+
+QByteArray OctResultCache::key(const QString& rawPath, const QByteArray& calib, const QByteArray& background,
+	int discomVal, int nScans, int nAlines)
+{
+	QFileInfo rawInfo(rawPath);
+	int32_t params[4] = { discomVal, nScans, nAlines, OCT_PROCESSING_VERSION };
+
+	QCryptographicHash hash(QCryptographicHash::Sha1);
+	hash.addData(rawInfo.fileName().toUtf8());
+	hash.addData(QByteArray::number(rawInfo.size()));
+	hash.addData(QByteArray::number(rawInfo.lastModified().toMSecsSinceEpoch()));
+	hash.addData(calib);
+	hash.addData(background);
+	hash.addData(reinterpret_cast<const char*>(params), sizeof(params));
+
+	return hash.result();
+}
+
+
+bool OctResultCache::read(const QString& path, const QByteArray& key, OctVolume& octVolume, np::FloatArray2& octProj, int& circShift)
+{
+	QFile file(path);
+	if (!file.open(QIODevice::ReadOnly))
+		return false;
+
+	// Validate the header
+	OctResultHeader header;
+	if ((file.read(reinterpret_cast<char*>(&header), sizeof(OctResultHeader)) != sizeof(OctResultHeader))
+		|| memcmp(header.magic, OCT_RESULT_MAGIC, 4) || (header.version != OCT_RESULT_VERSION)
+		|| (QByteArray(header.key, sizeof(header.key)) != key)
+		|| (header.valueBytes != sizeof(OctVolume::value_type)) || (header.fracBits != OCT_RESULT_FRAC_BITS))
+		return false;
+
+	// En face projection
+	np::FloatArray2 proj(header.height, header.nFrames);
+	qint64 projBytes = (qint64)sizeof(float) * proj.length();
+	if (!file.seek(header.projOffset) || (file.read(reinterpret_cast<char*>(proj.raw_ptr()), projBytes) != projBytes))
+		return false;
+	file.close();
+
+	// Frames are loaded on demand
+	if (!octVolume.attach(path, header.dataOffset, header.width, header.height, header.nFrames))
+		return false;
+
+	octProj = std::move(proj);
+	circShift = header.circShift;
+
+	return true;
+}
+
+bool OctResultCache::write(const QString& path, const QByteArray& key, OctVolume& octVolume, const np::FloatArray2& octProj, int circShift)
+{
+	QFile file(path);
+	if (!file.open(QIODevice::WriteOnly))
+		return false;
+
+	OctResultHeader header;
+	memset(&header, 0, sizeof(OctResultHeader));
+	header.version = OCT_RESULT_VERSION;
+	memcpy(header.key, key.constData(), std::min((int)sizeof(header.key), key.size()));
+	header.width = octVolume.width();
+	header.height = octVolume.height();
+	header.nFrames = octVolume.size();
+	header.valueBytes = sizeof(OctVolume::value_type);
+	header.fracBits = OCT_RESULT_FRAC_BITS;
+	header.circShift = circShift;
+	header.projOffset = sizeof(OctResultHeader);
+	header.dataOffset = header.projOffset + (int64_t)sizeof(float) * octProj.length();
+
+	// 1. Header placeholder (invalid magic)
+	if (file.write(reinterpret_cast<const char*>(&header), sizeof(OctResultHeader)) != sizeof(OctResultHeader))
+		return false;
+
+	// 2. En face projection
+	qint64 projBytes = (qint64)sizeof(float) * octProj.length();
+	if (file.write(reinterpret_cast<const char*>(octProj.raw_ptr()), projBytes) != projBytes)
+		return false;
+
+	// 3. Frames
+	qint64 frameBytes = (qint64)sizeof(OctVolume::value_type) * header.width * header.height;
+	for (int i = 0; i < header.nFrames; i++)
+	{
+		OctVolume::Frame frame = octVolume.at(i);
+		if (file.write(reinterpret_cast<const char*>(frame.raw_ptr()), frameBytes) != frameBytes)
+			return false;
+	}
+
+	// 4. Valid header
+	memcpy(header.magic, OCT_RESULT_MAGIC, 4);
+	if (!file.seek(0) || (file.write(reinterpret_cast<const char*>(&header), sizeof(OctResultHeader)) != sizeof(OctResultHeader)))
+		return false;
+
+	file.close();
+
+	return true;
+}
@@ -0,0 +1,50 @@
+#ifndef OCTRESULTCACHE_H
+#define OCTRESULTCACHE_H
+
+#include <QString>
+#include <QFile>
+#include <QByteArray>
+
+#include <iostream>
+
+#include <Havana2/Configuration.h>
+
+#include <Common/array.h>
+
+#include "OctVolume.h"
+
+// Processed result cache (*.hvr, next to the raw data): header, en face projection & frames
+// The header (with the key of the processing inputs) is written last, and the frames are loaded on demand.
+
+#define OCT_RESULT_MAGIC			"HVR1"
+#define OCT_RESULT_VERSION			1
+
+#pragma pack(push, 1)
+struct OctResultHeader
+{
+	char magic[4];
+	uint32_t version;
+	char key[20];
+	int32_t width;
+	int32_t height;
+	int32_t nFrames;
+	int32_t valueBytes; // sizeof(OctVolume::value_type)
+	int32_t fracBits; // fixed-point fraction bits (0 if float)
+	int32_t circShift; // of the en face projection
+	int64_t projOffset;
+	int64_t dataOffset;
+	int32_t reserved[4];
+};
+#pragma pack(pop)
+
+class OctResultCache
+{
+public:
+	static QByteArray key(const QString& rawPath, const QByteArray& calib, const QByteArray& background,
+		int discomVal, int nScans, int nAlines);
+
+	static bool read(const QString& path, const QByteArray& key, OctVolume& octVolume, np::FloatArray2& octProj, int& circShift);
+	static bool write(const QString& path, const QByteArray& key, OctVolume& octVolume, const np::FloatArray2& octProj, int circShift);
+};
+
+#endif // OCTRESULTCACHE_H
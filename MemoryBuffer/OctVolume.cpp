@@ -0,0 +1,229 @@
+
+#include "OctVolume.h"
+
+#include <QDir>
+
+#include <ipps.h>
+
+
+OctVolume::OctVolume(size_t memoryBudget) :
+	m_memoryBudget(memoryBudget), m_width(0), m_height(0), m_nFrames(0),
+	m_frameBytes(0), m_capacity(0), m_nResident(0), m_pFile(nullptr), m_fileOffset(0)
+{
+}
+
+OctVolume::~OctVolume()
+{
+	clear();
+}
+
+
+bool OctVolume::allocate(int width, int height, int nFrames)
+{
+	clear();
+
+	std::unique_lock<std::mutex> lock(m_mtx);
+
+	reset(width, height, nFrames);
+
+	// In-memory volume if it fits in the budget
+	if (m_capacity >= nFrames)
+		return true;
+
+	// Scratch file for the frames out of the cache
+	QTemporaryFile* pScratch = new QTemporaryFile(QDir::tempPath() + "/Havana2_XXXXXX.volume");
+	if (!pScratch->open() || !pScratch->resize((qint64)m_frameBytes * (qint64)nFrames))
+	{
+		printf("[ERROR] Failed to create the scratch file of the result volume.\n");
+		delete pScratch;
+		reset(0, 0, 0);
+		return false;
+	}
+	m_pFile = pScratch;
+
+	printf("Result volume is out of the memory budget. (cached frames: %d / %d)\n", m_capacity, nFrames);
+
+	return true;
+}
+
+bool OctVolume::attach(const QString& path, qint64 offset, int width, int height, int nFrames)
+{
+	clear();
+
+	std::unique_lock<std::mutex> lock(m_mtx);
+
+	QFile* pFile = new QFile(path);
+	if (!pFile->open(QIODevice::ReadOnly) || (pFile->size() < offset + (qint64)sizeof(value_type) * width * height * nFrames))
+	{
+		delete pFile;
+		return false;
+	}
+
+	// Every frame is loaded from the file on demand (modified frames are kept in memory)
+	reset(width, height, nFrames);
+	m_onDisk.assign(nFrames, true);
+	m_pFile = pFile;
+	m_fileOffset = offset;
+
+	return true;
+}
+
+void OctVolume::clear()
+{
+	std::unique_lock<std::mutex> lock(m_mtx);
+
+	// Pinned frames are freed when their last copy is released
+	m_pages.clear();
+	m_onDisk.clear();
+	m_lru.clear();
+	m_nResident = 0;
+
+	if (m_pFile)
+	{
+		delete m_pFile;
+		m_pFile = nullptr;
+	}
+	m_fileOffset = 0;
+
+	m_nFrames = 0;
+}
+
+void OctVolume::reset(int width, int height, int nFrames)
+{
+	m_width = width;
+	m_height = height;
+	m_nFrames = nFrames;
+	m_frameBytes = sizeof(value_type) * (size_t)width * (size_t)height;
+
+	m_pages.resize(nFrames);
+	for (Page& page : m_pages)
+	{
+		page.lru = m_lru.end();
+		page.dirty = false;
+	}
+	m_onDisk.assign(nFrames, false);
+
+	m_capacity = (int)std::max(m_memoryBudget / std::max(m_frameBytes, (size_t)1), (size_t)1);
+	m_capacity = std::min(m_capacity, std::max(nFrames, 1));
+}
+
+
+OctVolume::Frame OctVolume::at(int frame, bool modify)
+{
+	std::unique_lock<std::mutex> lock(m_mtx);
+
+	if ((frame < 0) || (frame >= m_nFrames))
+		return Frame();
+
+	Page& page = m_pages.at(frame);
+	if (page.data)
+	{
+		// Cache hit
+		m_lru.splice(m_lru.begin(), m_lru, page.lru);
+	}
+	else
+	{
+		// Cache miss
+		if (m_nResident >= m_capacity)
+			evict();
+
+		page.data = std::shared_ptr<value_type>(new value_type[m_frameBytes / sizeof(value_type)], std::default_delete<value_type[]>());
+		if (!m_onDisk.at(frame) || !load(frame, page.data.get()))
+			memset(page.data.get(), 0, m_frameBytes);
+		page.dirty = false;
+
+		m_lru.push_front(frame);
+		page.lru = m_lru.begin();
+		m_nResident++;
+	}
+	page.dirty |= modify;
+
+	// The returned array shares the ownership of the page (pinned while it is alive)
+	Frame arr(page.data.get(), m_width, m_height);
+	arr._address = page.data;
+
+	return arr;
+}
+
+np::FloatArray2 OctVolume::atFloat(int frame)
+{
+#ifdef OCT_DB_FIXED_POINT
+	Frame arr = at(frame);
+	if (arr.length() == 0)
+		return np::FloatArray2();
+
+	np::FloatArray2 img(m_width, m_height);
+	toDb(arr.raw_ptr(), img.raw_ptr(), img.length());
+
+	return img;
+#else
+	return at(frame);
+#endif
+}
+
+
+void OctVolume::toDb(const value_type* src, float* dst, int len)
+{
+#ifdef OCT_DB_FIXED_POINT
+	ippsConvert_16s32f_Sfs(src, dst, len, OCT_DB_FRAC_BITS);
+#else
+	memcpy(dst, src, sizeof(float) * len);
+#endif
+}
+
+float OctVolume::maxDb(const value_type* src, int len)
+{
+	value_type maxVal;
+#ifdef OCT_DB_FIXED_POINT
+	ippsMax_16s(src, len, &maxVal);
+#else
+	ippsMax_32f(src, len, &maxVal);
+#endif
+	return toDb(maxVal);
+}
+
+
+bool OctVolume::load(int frame, value_type* data)
+{
+	return m_pFile->seek(m_fileOffset + (qint64)m_frameBytes * frame)
+		&& (m_pFile->read(reinterpret_cast<char*>(data), (qint64)m_frameBytes) == (qint64)m_frameBytes);
+}
+
+bool OctVolume::spill(int frame, const value_type* data)
+{
+	if (!m_pFile->isWritable()) return false; // attached file
+
+	if (!m_pFile->seek(m_fileOffset + (qint64)m_frameBytes * frame)
+		|| (m_pFile->write(reinterpret_cast<const char*>(data), (qint64)m_frameBytes) != (qint64)m_frameBytes))
+	{
+		printf("[ERROR] Failed to write the frame to the scratch file. (%d)\n", frame);
+		return false;
+	}
+
+	return true;
+}
+
+void OctVolume::evict()
+{
+	if (!m_pFile) return;
+
+	// Release the least recently used frames that are not pinned
+	for (auto it = m_lru.end(); (it != m_lru.begin()) && (m_nResident >= m_capacity); )
+	{
+		--it;
+		Page& page = m_pages.at(*it);
+		if (page.data.use_count() > 1) continue;
+
+		if (page.dirty)
+		{
+			if (!spill(*it, page.data.get())) continue;
+			m_onDisk[*it] = true;
+		}
+
+		page.data.reset();
+		page.dirty = false;
+		page.lru = m_lru.end();
+		it = m_lru.erase(it);
+		m_nResident--;
+	}
+}
@@ -0,0 +1,96 @@
+#ifndef OCTVOLUME_H
+#define OCTVOLUME_H
+
+#include <QString>
+#include <QTemporaryFile>
+
+#include <iostream>
+#include <vector>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <algorithm>
+#include <cstring>
+
+#include <Havana2/Configuration.h>
+
+#include <Common/array.h>
+
+// Disk-backed volume of processed OCT images (LRU cache in a memory budget, spilled to a scratch file)
+// A frame returned by at() is pinned until all of its copies are released.
+
+class OctVolume
+{
+public:
+#ifdef OCT_DB_FIXED_POINT
+	typedef int16_t value_type;
+#else
+	typedef float value_type;
+#endif
+	typedef np::Array<value_type, 2> Frame;
+
+public:
+	explicit OctVolume(size_t memoryBudget = (size_t)VOLUME_MEMORY_BUDGET << 20);
+	virtual ~OctVolume();
+
+private: // Not to call copy constrcutor and copy assignment operator
+	OctVolume(const OctVolume&);
+	OctVolume& operator=(const OctVolume&);
+
+public:
+	bool allocate(int width, int height, int nFrames);
+	bool attach(const QString& path, qint64 offset, int width, int height, int nFrames); // read-only
+	void clear();
+	inline void setMemoryBudget(size_t memoryBudget) { m_memoryBudget = memoryBudget; } // from the next allocate/attach
+
+	Frame at(int frame, bool modify = false);
+	np::FloatArray2 atFloat(int frame); // dB image (a copy if fixed-point)
+
+	// Conversion of the stored values to dB
+	static inline float toDb(value_type value)
+	{
+#ifdef OCT_DB_FIXED_POINT
+		return (float)value / (float)(1 << OCT_DB_FRAC_BITS);
+#else
+		return value;
+#endif
+	}
+	static void toDb(const value_type* src, float* dst, int len);
+	static float maxDb(const value_type* src, int len);
+
+	inline int width() const { return m_width; }
+	inline int height() const { return m_height; }
+	inline int size() const { return m_nFrames; }
+	inline bool isOutOfCore() const { return m_pFile != nullptr; }
+
+private:
+	struct Page
+	{
+		std::shared_ptr<value_type> data;
+		std::list<int>::iterator lru;
+		bool dirty;
+	};
+
+	// should be called with m_mtx locked
+	void reset(int width, int height, int nFrames);
+	bool load(int frame, value_type* data);
+	bool spill(int frame, const value_type* data);
+	void evict();
+
+private:
+	size_t m_memoryBudget;
+	int m_width, m_height, m_nFrames;
+	size_t m_frameBytes;
+	int m_capacity; // frames in the cache
+
+	std::vector<Page> m_pages;
+	std::vector<bool> m_onDisk;
+	std::list<int> m_lru; // front: most recently used
+	int m_nResident;
+
+	QFile* m_pFile; // scratch or attached file
+	qint64 m_fileOffset;
+	std::mutex m_mtx;
+};
+
+#endif // OCTVOLUME_H
@@ -0,0 +1,259 @@
+
+#include "RenderCache.h"
+
+#include <algorithm>
+#include <cstring>
+
+
+RenderCache::RenderCache(OctVolume& octVolume) :
+	m_octVolume(octVolume), m_width(0), m_height(0), m_pCirc(nullptr),
+	m_bValidParams(false), m_generation(0), m_bStop(false)
+{
+	memset(&m_params, 0, sizeof(RenderParams));
+}
+
+RenderCache::~RenderCache()
+{
+	clear();
+}
+
+
+void RenderCache::allocate(int width, int height, circularize* pCirc, const std::function<bool(int)>& isReady)
+{
+	clear();
+
+	m_width = width;
+	m_height = height;
+	m_pCirc = pCirc;
+	m_isReady = isReady;
+
+	m_kernel = display_kernel(width, height);
+
+	start();
+}
+
+void RenderCache::clear()
+{
+	stop();
+
+	std::unique_lock<std::mutex> lock(m_mtx);
+
+	m_entries.clear();
+	m_lru.clear();
+	m_prefetch.clear();
+	m_generation++;
+
+	m_pCircDisplay.reset();
+
+	m_width = 0;
+	m_height = 0;
+}
+
+
+void RenderCache::setParams(const RenderParams& params)
+{
+	std::unique_lock<std::mutex> lock(m_mtx);
+
+	bool sameImages = m_bValidParams && (params.dbMin == m_params.dbMin) && (params.dbMax == m_params.dbMax)
+		&& (params.circShift == m_params.circShift) && (params.galvoShift == m_params.galvoShift);
+	bool sameDiameter = m_bValidParams && (params.circDiameter == m_params.circDiameter);
+	if (sameImages && sameDiameter)
+		return;
+
+	m_params = params;
+	m_bValidParams = true;
+
+	if (!sameDiameter)
+	{
+		// Circularize map of the display diameter (shared LUT)
+		int fullDiameter = 2 * CIRC_RADIUS;
+		if (m_pCirc && (params.circDiameter > 0) && (params.circDiameter != fullDiameter))
+			m_pCircDisplay = std::make_shared<circularize>(CIRC_RADIUS, m_pCirc->alines, false, params.circDiameter);
+		else
+			m_pCircDisplay.reset();
+	}
+
+	if (sameImages)
+	{
+		// Only the circularized images depend on the diameter
+		for (auto it = m_entries.begin(); it != m_entries.end(); )
+		{
+			if (it->first % 2 == circ)
+			{
+				m_lru.erase(it->second.lru);
+				it = m_entries.erase(it);
+			}
+			else
+				++it;
+		}
+	}
+	else
+	{
+		// Every image depends on the parameters (both views)
+		m_entries.clear();
+		m_lru.clear();
+	}
+	m_prefetch.clear();
+	m_generation++;
+}
+
+
+np::Uint8Array2 RenderCache::get(int frame, view v)
+{
+	RenderParams params;
+	std::shared_ptr<circularize> pCircDisplay;
+	int generation;
+	{
+		std::unique_lock<std::mutex> lock(m_mtx);
+		if (m_width == 0)
+			return np::Uint8Array2();
+
+		np::Uint8Array2 img = find(frame, v);
+		if (img.length() != 0)
+			return img;
+
+		params = m_params;
+		pCircDisplay = m_pCircDisplay;
+		generation = m_generation;
+	}
+
+	// Cache miss: rendered in the calling thread
+	return render(frame, v, params, pCircDisplay ? pCircDisplay.get() : m_pCirc, generation);
+}
+
+void RenderCache::prefetch(int frame, view v)
+{
+	std::unique_lock<std::mutex> lock(m_mtx);
+
+	// Only the neighbors of the latest frame are worth rendering
+	m_prefetch.clear();
+	for (int d = 1; d <= RENDER_PREFETCH_FRAMES; d++)
+	{
+		if (frame + d < m_octVolume.size()) m_prefetch.push_back(key(frame + d, v));
+		if (frame - d >= 0) m_prefetch.push_back(key(frame - d, v));
+	}
+	m_cond.notify_all();
+}
+
+
+np::Uint8Array2 RenderCache::render(int frame, view v, const RenderParams& params, circularize* pCirc, int generation)
+{
+	if (v == circ)
+	{
+		// Circularized image from the rectangular image
+		np::Uint8Array2 rect_im;
+		{
+			std::unique_lock<std::mutex> lock(m_mtx);
+			rect_im = find(frame, rect);
+		}
+		if (rect_im.length() == 0)
+			rect_im = render(frame, rect, params, pCirc, generation);
+		if (rect_im.length() == 0)
+			return np::Uint8Array2();
+
+		np::Uint8Array2 circ_im(pCirc->diameter, pCirc->diameter);
+		(*pCirc)(rect_im, circ_im.raw_ptr(), "vertical", 0);
+		insert(frame, circ, circ_im, generation);
+
+		return circ_im;
+	}
+
+	np::FloatArray2 octImage = m_octVolume.atFloat(frame);
+	if (octImage.length() == 0)
+		return np::Uint8Array2();
+
+	// Scaling, circShift, transpose (A-lines in horizontal direction), galvo shift & median filtering
+	np::Uint8Array2 rect_im(m_height, m_width);
+	m_kernel(octImage.raw_ptr(), rect_im.raw_ptr(), (float)params.dbMin, (float)params.dbMax, params.circShift, params.galvoShift);
+	insert(frame, rect, rect_im, generation);
+
+	return rect_im;
+}
+
+np::Uint8Array2 RenderCache::find(int frame, view v)
+{
+	auto it = m_entries.find(key(frame, v));
+	if (it == m_entries.end())
+		return np::Uint8Array2();
+
+	m_lru.splice(m_lru.begin(), m_lru, it->second.lru);
+
+	return np::Uint8Array2(it->second.img); // shares the image
+}
+
+void RenderCache::insert(int frame, view v, const np::Uint8Array2& img, int generation)
+{
+	std::unique_lock<std::mutex> lock(m_mtx);
+
+	// Rendered with the previous parameters
+	if (generation != m_generation)
+		return;
+
+	int k = key(frame, v);
+	if (m_entries.find(k) != m_entries.end())
+		return;
+
+	while ((int)m_entries.size() >= 2 * RENDER_CACHE_FRAMES)
+	{
+		m_entries.erase(m_lru.back());
+		m_lru.pop_back();
+	}
+
+	m_lru.push_front(k);
+	Entry& entry = m_entries[k];
+	entry.img = img;
+	entry.lru = m_lru.begin();
+}
+
+
+void RenderCache::start()
+{
+	m_bStop = false;
+	for (int i = 0; i < RENDER_WORKERS; i++)
+		m_workers.push_back(std::thread([&]() { run(); }));
+}
+
+void RenderCache::stop()
+{
+	{
+		std::unique_lock<std::mutex> lock(m_mtx);
+		m_bStop = true;
+		m_cond.notify_all();
+	}
+
+	for (std::thread& worker : m_workers)
+		worker.join();
+	m_workers.clear();
+}
+
+void RenderCache::run()
+{
+	while (true)
+	{
+		int frame;
+		view v;
+		RenderParams params;
+		std::shared_ptr<circularize> pCircDisplay;
+		int generation;
+		{
+			std::unique_lock<std::mutex> lock(m_mtx);
+			m_cond.wait(lock, [&]() { return m_bStop || !m_prefetch.empty(); });
+			if (m_bStop)
+				break;
+
+			int k = m_prefetch.front();
+			m_prefetch.pop_front();
+			if (m_entries.find(k) != m_entries.end())
+				continue;
+
+			frame = k / 2;
+			v = (view)(k % 2);
+			params = m_params;
+			pCircDisplay = m_pCircDisplay;
+			generation = m_generation;
+		}
+
+		if (!m_isReady || m_isReady(frame))
+			render(frame, v, params, pCircDisplay ? pCircDisplay.get() : m_pCirc, generation);
+	}
+}
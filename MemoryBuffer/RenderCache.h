@@ -0,0 +1,96 @@
+#ifndef RENDERCACHE_H
+#define RENDERCACHE_H
+
+#include <iostream>
+#include <vector>
+#include <map>
+#include <list>
+#include <deque>
+#include <memory>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+
+#include <Havana2/Configuration.h>
+
+#include <Common/array.h>
+#include <Common/circularize.h>
+#include <Common/display_kernel.h>
+
+#include "OctVolume.h"
+
+// Display-ready 8-bit images of the result volume in an LRU cache keyed by (frame, view)
+// Neighbors of the displayed frame are rendered ahead by worker threads.
+
+struct RenderParams
+{
+	int dbMin, dbMax;
+	int circShift;
+	int galvoShift;
+	int circDiameter; // 0: full resolution
+};
+
+class RenderCache
+{
+public:
+	enum view { rect = 0, circ };
+
+public:
+	explicit RenderCache(OctVolume& octVolume);
+	virtual ~RenderCache();
+
+private: // Not to call copy constrcutor and copy assignment operator
+	RenderCache(const RenderCache&);
+	RenderCache& operator=(const RenderCache&);
+
+public:
+	// Frames are rendered only if isReady(frame) is true (e.g. processed frames)
+	void allocate(int width, int height, circularize* pCirc, const std::function<bool(int)>& isReady);
+	void clear();
+
+	void setParams(const RenderParams& params); // the cache is invalidated if changed
+
+	np::Uint8Array2 get(int frame, view v); // rendered now if not cached
+	void prefetch(int frame, view v);
+
+private:
+	np::Uint8Array2 render(int frame, view v, const RenderParams& params, circularize* pCirc, int generation);
+	np::Uint8Array2 find(int frame, view v); // should be called with m_mtx locked
+	void insert(int frame, view v, const np::Uint8Array2& img, int generation);
+
+	void start();
+	void stop();
+	void run();
+
+private:
+	struct Entry
+	{
+		np::Uint8Array2 img;
+		std::list<int>::iterator lru;
+	};
+	static inline int key(int frame, view v) { return 2 * frame + v; }
+
+	OctVolume& m_octVolume;
+	int m_width, m_height; // processed image (depth x A-lines)
+	display_kernel m_kernel; // scaling, shifts, transpose & median filtering (thread-safe)
+	circularize* m_pCirc; // full resolution
+	std::shared_ptr<circularize> m_pCircDisplay; // display diameter (nullptr: full resolution)
+	std::function<bool(int)> m_isReady;
+
+	RenderParams m_params;
+	bool m_bValidParams;
+	int m_generation; // increased whenever the cache is invalidated (images rendered before are discarded)
+
+	std::map<int, Entry> m_entries;
+	std::list<int> m_lru; // front: most recently used
+
+	std::deque<int> m_prefetch; // keys to be rendered
+	std::vector<std::thread> m_workers;
+	bool m_bStop;
+
+	std::mutex m_mtx;
+	std::condition_variable m_cond;
+};
+
+#endif // RENDERCACHE_H